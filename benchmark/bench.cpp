@@ -0,0 +1,845 @@
+// Headless benchmarks for olcPGEX_Font / olcPGEX_CustomFont.
+//
+// Builds against the stub engine in this directory, so it needs no window, GPU or image files:
+// fonts are synthesised in memory (plus their .olcfont metrics files in the temp directory) and
+// decal draws are counted instead of rendered. Results are written as JSON, one record per
+// benchmark, so runs can be compared over time.
+//
+//     font_bench [--filter <substring>] [--out <file.json>] [--min-time <seconds>]
+//     font_bench --check
+//
+// --check instead compares what the drawing paths draw, vertex by vertex, against each other and
+// against a plain model of the text, and that the stack formatted and string_view draws don't
+// allocate once warmed up, and exits with 1 if anything differs. ctest runs it.
+
+#include "olcPixelGameEngine.h"
+
+#define OLC_PGEX_FONT
+#include "../olcPGEX_Font.h"
+#define OLC_PGEX_CUSTOMFONT
+#include "../olcPGEX_CustomFont.h"
+#define OLC_PGEX_FONTCHAIN
+#include "../olcPGEX_FontChain.h"
+#define OLC_PGEX_TEXTBOX
+#include "../olcPGEX_TextBox.h"
+#define OLC_PGEX_TEXTCACHE
+#include "../olcPGEX_TextCache.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <new>
+#include <optional>
+#include <vector>
+
+// Every allocation of the process is counted, for the allocation checks. GCC takes the free()
+// in the replaced operator delete, once inlined, for a mismatch with new
+#if defined( __GNUC__ ) && !defined( __clang__ )
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+static std::atomic<size_t> nAllocations{ 0 };
+
+void* operator new( size_t nSize )
+{
+    nAllocations.fetch_add( 1, std::memory_order_relaxed );
+    if( void* p = std::malloc( nSize == 0 ? 1 : nSize ) )
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[]( size_t nSize ) { return operator new( nSize ); }
+void operator delete( void* p ) noexcept { std::free( p ); }
+void operator delete[]( void* p ) noexcept { std::free( p ); }
+void operator delete( void* p, size_t ) noexcept { std::free( p ); }
+void operator delete[]( void* p, size_t ) noexcept { std::free( p ); }
+
+namespace
+{
+    // ---------------------------------------------------------------------------------------
+    // Timing
+
+    struct Result
+    {
+        std::string name;
+        uint64_t    nIterations = 0;
+        double      fNsPerOp = 0.0;
+        double      fItemsPerSecond = 0.0;      // items (characters, glyphs, bytes...) per op / time per op
+        std::string sItems;
+        std::vector<std::pair<std::string, double>> vCounters;
+    };
+
+    struct Options
+    {
+        std::string sFilter;
+        std::string sOut;
+        double      fMinTime = 0.25;            // seconds per sample
+    };
+
+    Options options;
+    std::vector<Result> vResults;
+
+    // Runs op until a sample lasts fMinTime, takes the median of 5 samples
+    void Run( const std::string& name, double fItemsPerOp, const std::string& sItems, const std::function<void()>& op,
+              std::vector<std::pair<std::string, double>> vCounters = {} )
+    {
+        if( !options.sFilter.empty() && name.find( options.sFilter ) == std::string::npos )
+            return;
+
+        using clock = std::chrono::steady_clock;
+        op();   // warm up
+
+        uint64_t nIterations = 1;
+        for( ;; )
+        {
+            auto t0 = clock::now();
+            for( uint64_t i = 0; i < nIterations; i++ )
+                op();
+            double fSeconds = std::chrono::duration<double>( clock::now() - t0 ).count();
+            if( fSeconds >= options.fMinTime || nIterations >= ( 1ull << 40 ) )
+                break;
+            nIterations = fSeconds <= 0.0 ? nIterations * 10 : std::max( nIterations + 1, uint64_t( double( nIterations ) * options.fMinTime * 1.2 / fSeconds ) );
+        }
+
+        std::vector<double> vSamples;
+        for( int s = 0; s < 5; s++ )
+        {
+            auto t0 = clock::now();
+            for( uint64_t i = 0; i < nIterations; i++ )
+                op();
+            vSamples.push_back( std::chrono::duration<double, std::nano>( clock::now() - t0 ).count() / double( nIterations ) );
+        }
+        std::sort( vSamples.begin(), vSamples.end() );
+
+        Result r;
+        r.name = name;
+        r.nIterations = nIterations;
+        r.fNsPerOp = vSamples[vSamples.size() / 2];
+        r.fItemsPerSecond = fItemsPerOp * 1e9 / r.fNsPerOp;
+        r.sItems = sItems;
+        r.vCounters = std::move( vCounters );
+        fprintf( stderr, "%-44s %12.1f ns/op %14.0f %s/s\n", name.c_str(), r.fNsPerOp, r.fItemsPerSecond, sItems.c_str() );
+        vResults.push_back( std::move( r ) );
+    }
+
+    // Keeps the optimiser from discarding results
+    volatile int32_t nSink = 0;
+
+
+    // ---------------------------------------------------------------------------------------
+    // Test data
+
+    struct Random
+    {
+        uint64_t state = 0x9E3779B97F4A7C15ull;
+        uint32_t Next() { state = state * 6364136223846793005ull + 1442695040888963407ull; return uint32_t( state >> 33 ); }
+        uint32_t Below( uint32_t n ) { return Next() % n; }
+    };
+
+    void AppendUtf8( std::string& s, uint32_t c )
+    {
+        if( c < 0x80 ) s += char( c );
+        else if( c < 0x800 ) { s += char( 0xC0 | ( c >> 6 ) ); s += char( 0x80 | ( c & 0x3F ) ); }
+        else if( c < 0x10000 ) { s += char( 0xE0 | ( c >> 12 ) ); s += char( 0x80 | ( ( c >> 6 ) & 0x3F ) ); s += char( 0x80 | ( c & 0x3F ) ); }
+        else { s += char( 0xF0 | ( c >> 18 ) ); s += char( 0x80 | ( ( c >> 12 ) & 0x3F ) ); s += char( 0x80 | ( ( c >> 6 ) & 0x3F ) ); s += char( 0x80 | ( c & 0x3F ) ); }
+    }
+
+    // Printable ascii with spaces and the odd newline
+    std::string AsciiCorpus( size_t nChars )
+    {
+        static const char* words[] = { "the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog", "Player", "HP:", "100/100", "[INFO]", "loaded", "level" };
+        Random rng;
+        std::string s;
+        while( s.size() < nChars )
+        {
+            s += words[rng.Below( 14 )];
+            s += rng.Below( 12 ) == 0 ? '\n' : ' ';
+        }
+        s.resize( nChars );
+        return s;
+    }
+
+    // Mostly ascii with about one in ten characters from elsewhere - a chat or log view
+    std::string MixedCorpus( size_t nChars, const std::vector<uint32_t>& vExtra )
+    {
+        std::string ascii = AsciiCorpus( nChars );
+        Random rng;
+        std::string s;
+        for( char c : ascii )
+        {
+            if( rng.Below( 10 ) == 0 ) AppendUtf8( s, vExtra[rng.Below( uint32_t( vExtra.size() ) )] );
+            else s += c;
+        }
+        return s;
+    }
+
+    std::string CodepointCorpus( size_t nChars, const std::vector<uint32_t>& vCodepoints )
+    {
+        Random rng;
+        std::string s;
+        for( size_t i = 0; i < nChars; i++ )
+            AppendUtf8( s, vCodepoints[rng.Below( uint32_t( vCodepoints.size() ) )] );
+        return s;
+    }
+
+    size_t CountCodepoints( const std::string& s )
+    {
+        size_t n = 0;
+        for( char c : s )
+            n += ( uint8_t( c ) & 0xC0 ) != 0x80;
+        return n;
+    }
+
+    // The first n CJK ideographs - a typical large custom font
+    std::vector<uint32_t> CjkCodepoints( size_t n )
+    {
+        std::vector<uint32_t> v;
+        for( uint32_t c = 0x4E00; v.size() < n; c++ )
+            v.push_back( c );
+        return v;
+    }
+
+
+    // ---------------------------------------------------------------------------------------
+    // Synthetic fonts, in the layouts the generators produce
+
+    olc::Pixel Value( uint32_t n ) { olc::Pixel p; p.n = n; return p; }
+
+    std::filesystem::path TempDir()
+    {
+        static std::filesystem::path dir = []
+        {
+            auto d = std::filesystem::temp_directory_path() / "olcpgex_font_bench";
+            std::filesystem::create_directories( d );
+            return d;
+        }();
+        return dir;
+    }
+
+    void WriteMetrics( const std::string& sFontFile, int32_t nCharWidth, int32_t nCharHeight, std::vector<olc::font::MetricsGlyph> vGlyphs, uint32_t nFlags )
+    {
+        std::sort( vGlyphs.begin(), vGlyphs.end(), []( auto& a, auto& b ) { return a.nCodepoint < b.nCodepoint; } );
+        olc::font::MetricsHeader header = {};
+        std::memcpy( header.magic, "OLCF", 4 );
+        header.nVersion = olc::font::MetricsView::VERSION;
+        header.nGlyphs = uint32_t( vGlyphs.size() );
+        header.nCharWidth = nCharWidth;
+        header.nCharHeight = nCharHeight;
+        header.nPages = 1;
+        header.nFlags = nFlags;
+        std::ofstream file( olc::font::MetricsFileName( sFontFile ), std::ios::binary );
+        file.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+        file.write( reinterpret_cast<const char*>( vGlyphs.data() ), std::streamsize( vGlyphs.size() * sizeof( olc::font::MetricsGlyph ) ) );
+    }
+
+    // generatefont.py's original layout: 16x6 cells, metrics in the last pixel row. With
+    // bMetricsFile the glyphs are also described by a .olcfont file next to the png. pGlyphs
+    // receives the metrics either way.
+    std::string MakeAsciiFont( const std::string& sName, bool bMetricsFile, std::vector<olc::font::MetricsGlyph>* pGlyphs = nullptr )
+    {
+        const int cw = 14, ch = 18, xoffset = 2;
+        std::string sFile = ( TempDir() / sName ).string();
+        olc::Sprite s( 16 * cw, 6 * ch + 1 );
+        std::vector<olc::font::MetricsGlyph> vGlyphs;
+        for( int i = 0; i < 96; i++ )
+        {
+            int w = 5 + i % 7;
+            for( int y = 0; y < ch - 2; y++ )
+                for( int x = 0; x < w; x++ )
+                    s.SetPixel( i % 16 * cw + xoffset + x, i / 16 * ch + y, olc::Pixel( 255, 255, 255, uint8_t( 40 + y * 10 ) ) );
+            s.SetPixel( 3 + i, s.height - 1, Value( uint32_t( w ) ) );
+            vGlyphs.push_back( { uint32_t( 32 + i ), int16_t( i % 16 * cw + xoffset ), int16_t( i / 16 * ch ), int16_t( w ), int16_t( ch - 1 ), int16_t( w ), 0 } );
+        }
+        s.SetPixel( 0, s.height - 1, olc::Pixel( 'F', 'O', 'N', 'T' ) );
+        s.SetPixel( 1, s.height - 1, Value( 1 ) );
+        s.SetPixel( 2, s.height - 1, Value( xoffset ) );
+        olc::Sprite::Register( sFile, s );
+        if( pGlyphs != nullptr )
+            *pGlyphs = vGlyphs;
+        if( bMetricsFile )
+            WriteMetrics( sFile, cw, ch, vGlyphs, olc::font::ATLAS_GRID );
+        else
+            std::filesystem::remove( olc::font::MetricsFileName( sFile ) );
+        return sFile;
+    }
+
+    // generatecustomfont.py's original layout: a sqrt(n) grid with the CFON data rows at the bottom
+    std::string MakeCustomFont( const std::string& sName, const std::vector<uint32_t>& vCodepoints, bool bMetricsFile,
+                                std::vector<olc::font::MetricsGlyph>* pGlyphs = nullptr )
+    {
+        const int cw = 20, ch = 22, xoffset = 2;
+        std::string sFile = ( TempDir() / sName ).string();
+        int n = int( vCodepoints.size() );
+        int per = int( std::ceil( std::sqrt( double( n ) ) ) );
+        int w = per * cw;
+        int rows = ( n * 2 + 6 + w - 1 ) / w;
+        olc::Sprite s( w, per * ch + rows );
+        std::vector<olc::font::MetricsGlyph> vGlyphs;
+        for( int i = 0; i < n; i++ )
+        {
+            int gw = 10 + i % 8;
+            for( int y = 0; y < ch - 2; y++ )
+                for( int x = 0; x < gw; x++ )
+                    s.SetPixel( i % per * cw + xoffset + x, i / per * ch + y, olc::Pixel( 255, 255, 255, uint8_t( 60 + y * 8 ) ) );
+            vGlyphs.push_back( { vCodepoints[i], int16_t( i % per * cw + xoffset ), int16_t( i / per * ch ), int16_t( gw ), int16_t( ch - 1 ), int16_t( gw ), 0 } );
+        }
+        int dataRow = s.height - rows;
+        auto put = [&]( int offset, olc::Pixel p ) { s.SetPixel( offset % w, dataRow + offset / w, p ); };
+        put( 0, olc::Pixel( 'C', 'F', 'O', 'N' ) );
+        put( 1, Value( 1 ) ); put( 2, Value( uint32_t( n ) ) ); put( 3, Value( xoffset ) ); put( 4, Value( cw ) ); put( 5, Value( ch ) );
+        for( int i = 0; i < n; i++ )
+        {
+            put( 6 + i * 2, Value( uint32_t( 10 + i % 8 ) ) );
+            put( 7 + i * 2, Value( vCodepoints[i] ) );
+        }
+        olc::Sprite::Register( sFile, s );
+        if( pGlyphs != nullptr )
+            *pGlyphs = vGlyphs;
+        if( bMetricsFile )
+            WriteMetrics( sFile, cw, ch, vGlyphs, olc::font::ATLAS_GRID );
+        else
+            std::filesystem::remove( olc::font::MetricsFileName( sFile ) );
+        return sFile;
+    }
+
+
+    // Gives the extensions the stub engine to draw with
+    struct Engine : public olc::PGEX
+    {
+        static void Attach( olc::PixelGameEngine* engine ) { pge = engine; }
+    };
+
+
+    // ---------------------------------------------------------------------------------------
+    // Benchmarks
+
+    void BenchDecode()
+    {
+        const std::string sAscii = AsciiCorpus( 64 * 1024 );
+        const std::string sMixed = MixedCorpus( 64 * 1024, { 0xE9, 0xFC, 0x3042, 0x30A2, 0x4E16, 0x1F600 } );
+        const std::string sCjk   = CodepointCorpus( 32 * 1024, CjkCodepoints( 3000 ) );
+        std::vector<uint32_t> vOut;
+
+        for( auto& [name, text] : { std::pair<const char*, const std::string*>{ "ascii", &sAscii }, { "mixed", &sMixed }, { "cjk", &sCjk } } )
+        {
+            const std::string& s = *text;
+            Run( std::string( "utf8/decode/" ) + name, double( s.size() ), "bytes", [&]
+            {
+                olc::font::DecodeUtf8( s, vOut );
+                nSink = int32_t( vOut.size() );
+            } );
+            Run( std::string( "utf8/decode_per_codepoint/" ) + name, double( s.size() ), "bytes", [&]
+            {
+                int n = 0;
+                for( size_t i = 0; i < s.size(); n++ )
+                    olc::font::DecodeUtf8Codepoint( s, i );
+                nSink = n;
+            } );
+        }
+    }
+
+
+    void BenchFont()
+    {
+        olc::Font font( MakeAsciiFont( "ascii.png", true ) );
+        olc::PixelGameEngine engine;
+        engine.bRecord = false;
+        Engine::Attach( &engine );
+
+        const std::string sLine = AsciiCorpus( 64 );
+        const std::string sPage = AsciiCorpus( 4096 );
+
+        Run( "font/get_text_size_prop/64", 64, "chars", [&] { nSink = font.GetTextSizeProp( sLine ).x; } );
+        Run( "font/get_text_size_prop/4096", 4096, "chars", [&] { nSink = font.GetTextSizeProp( sPage ).x; } );
+
+        for( auto& [name, text] : { std::pair<const char*, const std::string*>{ "64", &sLine }, { "4096", &sPage } } )
+        {
+            const std::string& s = *text;
+            double nChars = double( s.size() );
+
+            engine.ClearDrawn();
+            font.DrawStringPropDecal( { 0.0f, 0.0f }, s );
+            std::vector<std::pair<std::string, double>> vCounters = { { "decal_instances_per_op", double( engine.nInstances ) }, { "vertices_per_op", double( engine.nVertices ) } };
+
+            Run( std::string( "font/draw_string_prop_decal/" ) + name, nChars, "chars", [&] { font.DrawStringPropDecal( { 10.0f, 10.0f }, s ); }, vCounters );
+            Run( std::string( "font/draw_rotated_string_prop_decal/" ) + name, nChars, "chars", [&] { font.DrawRotatedStringPropDecal( { 10.0f, 10.0f }, s, 0.3f ); } );
+            Run( std::string( "font/draw_string_decal/" ) + name, nChars, "chars", [&] { font.DrawStringDecal( { 10.0f, 10.0f }, s ); } );
+
+            olc::TextLayout layout = font.LayoutText( s );
+            Run( std::string( "font/draw_layout_decal/" ) + name, nChars, "chars", [&] { font.DrawStringDecal( { 10.0f, 10.0f }, layout ); } );
+        }
+
+        // A scrolled log: 10000 lines of which the screen shows about 40
+        std::string sLog;
+        for( int i = 0; i < 10000; i++ )
+        {
+            std::string sLine = AsciiCorpus( 40 + i % 60 );
+            std::replace( sLine.begin(), sLine.end(), '\n', ' ' );
+            sLog += "[" + std::to_string( i ) + "] " + sLine + "\n";
+        }
+        engine.ClearDrawn();
+        font.DrawStringPropDecal( { 0.0f, -90000.0f }, sLog );
+        Run( "font/draw_string_prop_decal/log_10000_lines", 1, "strings", [&] { font.DrawStringPropDecal( { 0.0f, -90000.0f }, sLog ); },
+             { { "vertices_per_op", double( engine.nVertices ) } } );
+
+        // A debug overlay, formatted on the stack
+        Run( "font/draw_formatted_decal/overlay", 1, "strings", [&] { font.DrawFormattedDecal( { 4.0f, 4.0f }, olc::WHITE, "FPS ", 60, " dt ", olc::font::Fixed{ 16.6667, 2 }, " x ", 123.5f ); } );
+
+        // Name tags: 5000 short centred labels spread over the screen, some rotated
+        std::vector<std::string> vNames;
+        std::vector<olc::TextLabel> vLabels;
+        for( int i = 0; i < 5000; i++ )
+            vNames.push_back( "unit " + std::to_string( i * 7919 % 10007 ) );
+        for( int i = 0; i < 5000; i++ )
+        {
+            olc::TextLabel label;
+            label.pos = { float( i * 37 % 1280 ), float( i * 53 % 720 ) };
+            label.sText = vNames[i];
+            label.align = { 0.5f, 1.0f };
+            label.fAngle = i % 8 == 0 ? 0.3f : 0.0f;
+            vLabels.push_back( label );
+        }
+        for( uint32_t nThreads : { 1u, 4u } )
+        {
+            font.SetLayoutThreads( nThreads );
+            Run( "font/draw_labels_decal/5000/threads_" + std::to_string( nThreads ), 5000, "labels", [&] { font.DrawLabelsDecal( vLabels ); } );
+        }
+        font.SetLayoutThreads( 1 );
+
+        olc::Sprite target( 1024, 1024 );
+        Run( "font/draw_string_prop_sprite/4096", 4096, "chars", [&] { font.DrawStringProp( &target, { 0, 0 }, sPage ); } );
+    }
+
+
+    void BenchCustomFont()
+    {
+        olc::PixelGameEngine engine;
+        engine.bRecord = false;
+        Engine::Attach( &engine );
+
+        for( size_t nGlyphs : { 100, 1000, 10000 } )
+        {
+            auto vCodepoints = CjkCodepoints( nGlyphs );
+            olc::CustomFont font( MakeCustomFont( "cjk" + std::to_string( nGlyphs ) + ".png", vCodepoints, true ) );
+
+            // Random glyphs from the whole set defeat any locality in the lookup
+            const std::string s = CodepointCorpus( 4096, vCodepoints );
+            const std::string n = std::to_string( nGlyphs );
+
+            Run( "customfont/lookup_get_text_size_prop/" + n, 4096, "chars", [&] { nSink = font.GetTextSizeProp( s ).x; } );
+            Run( "customfont/draw_string_prop_decal/" + n, 4096, "chars", [&] { font.DrawStringPropDecal( { 10.0f, 10.0f }, s ); } );
+        }
+
+        // Chat style text: mostly ascii, some kana and kanji, the odd character the font lacks
+        std::vector<uint32_t> vCodepoints;
+        for( uint32_t c = 32; c < 127; c++ ) vCodepoints.push_back( c );
+        for( uint32_t c = 0x3041; c < 0x3097; c++ ) vCodepoints.push_back( c );
+        for( auto c : CjkCodepoints( 2000 ) ) vCodepoints.push_back( c );
+        vCodepoints.push_back( 0xFFFD );
+        olc::CustomFont font( MakeCustomFont( "chat.png", vCodepoints, true ) );
+        const std::string s = MixedCorpus( 4096, { 0x3042, 0x3044, 0x4E00, 0x4E8C, 0x1F600 } );
+        const double nChars = double( CountCodepoints( s ) );
+
+        Run( "customfont/get_text_size_prop/mixed", nChars, "chars", [&] { nSink = font.GetTextSizeProp( s ).x; } );
+        Run( "customfont/draw_string_prop_decal/mixed", nChars, "chars", [&] { font.DrawStringPropDecal( { 10.0f, 10.0f }, s ); } );
+
+        // The same text split between an ascii font and a kana / kanji font
+        olc::Font latin( MakeAsciiFont( "chain_latin.png", true ) );
+        olc::CustomFont cjk( MakeCustomFont( "chain_cjk.png", std::vector<uint32_t>( vCodepoints.begin() + 95, vCodepoints.end() ), true ) );
+        olc::FontChain chain;
+        chain.Add( latin );
+        chain.Add( cjk );
+        Run( "fontchain/get_text_size_prop/mixed", nChars, "chars", [&] { nSink = chain.GetTextSizeProp( s ).x; } );
+        Run( "fontchain/draw_string_prop_decal/mixed", nChars, "chars", [&] { chain.DrawStringPropDecal( { 10.0f, 10.0f }, s ); } );
+    }
+
+
+    void BenchTextBox()
+    {
+        olc::Font font( MakeAsciiFont( "textbox.png", true ) );
+        olc::PixelGameEngine engine;
+        engine.bRecord = false;
+        Engine::Attach( &engine );
+
+        // A chat window 300 pixels wide with 10000 messages of history, gaining one a frame
+        const std::string sMessage = AsciiCorpus( 120 );
+        olc::TextBox chat( font, 300.0f );
+        for( int i = 0; i < 10000; i++ )
+            chat.Append( sMessage );
+        nSink = chat.Size().y;
+
+        Run( "textbox/append_message/history_10000", 1, "messages", [&]
+        {
+            chat.Append( sMessage );
+            chat.EraseParagraphs( 0 );
+            chat.Draw( { 10.0f, float( engine.ScreenHeight() - chat.Size().y ) } );
+        } );
+        Run( "textbox/rewrap/10000", 10000, "paragraphs", [&]
+        {
+            chat.SetWidth( chat.Width() == 300.0f ? 299.0f : 300.0f );
+            nSink = chat.Size().y;
+        } );
+    }
+
+
+    void BenchLoad()
+    {
+        // Image decoding is replaced by a copy from the stub's registry, so these measure the
+        // metrics parsing and glyph table construction on top of that copy
+        std::string sAsciiPixels  = MakeAsciiFont( "load_ascii_pixels.png", false );
+        std::string sAsciiMetrics = MakeAsciiFont( "load_ascii_metrics.png", true );
+        Run( "load/font/embedded_metrics", 96, "glyphs", [&] { olc::Font f( sAsciiPixels, nullptr, olc::font::DeferDecals ); } );
+        Run( "load/font/metrics_file", 96, "glyphs", [&] { olc::Font f( sAsciiMetrics, nullptr, olc::font::DeferDecals ); } );
+
+        for( size_t nGlyphs : { 100, 1000, 10000 } )
+        {
+            auto vCodepoints = CjkCodepoints( nGlyphs );
+            const std::string n = std::to_string( nGlyphs );
+            std::string sPixels  = MakeCustomFont( "load_cjk_pixels" + n + ".png", vCodepoints, false );
+            std::string sMetrics = MakeCustomFont( "load_cjk_metrics" + n + ".png", vCodepoints, true );
+            Run( "load/customfont/embedded_metrics/" + n, double( nGlyphs ), "glyphs", [&] { olc::CustomFont f( sPixels, nullptr, olc::font::DeferDecals ); } );
+            Run( "load/customfont/metrics_file/" + n, double( nGlyphs ), "glyphs", [&] { olc::CustomFont f( sMetrics, nullptr, olc::font::DeferDecals ); } );
+        }
+    }
+
+
+    // ---------------------------------------------------------------------------------------
+    // Checks
+
+    int nFailures = 0;
+
+    void Check( const std::string& name, bool bPassed )
+    {
+        fprintf( stderr, "%-56s %s\n", name.c_str(), bPassed ? "ok" : "FAILED" );
+        nFailures += bPassed ? 0 : 1;
+    }
+
+    // Every vertex drawn, in order
+    struct Drawn
+    {
+        std::vector<olc::vf2d>  vPos;
+        std::vector<olc::vf2d>  vUV;
+        std::vector<olc::Pixel> vCol;
+
+        bool operator==( const Drawn& other ) const
+        {
+            auto same = []( const std::vector<olc::vf2d>& a, const std::vector<olc::vf2d>& b )
+            {
+                return a.size() == b.size() && std::equal( a.begin(), a.end(), b.begin(), []( auto& p, auto& q ) { return p.x == q.x && p.y == q.y; } );
+            };
+            return same( vPos, other.vPos ) && same( vUV, other.vUV ) && vCol.size() == other.vCol.size() &&
+                   std::equal( vCol.begin(), vCol.end(), other.vCol.begin(), []( auto& p, auto& q ) { return p.n == q.n; } );
+        }
+    };
+
+    Drawn Capture( olc::PixelGameEngine& engine, const std::function<void()>& draw )
+    {
+        engine.bRecord = true;
+        engine.ClearDrawn();
+        draw();
+        Drawn drawn;
+        for( auto& di : engine.vDecalInstances )
+        {
+            drawn.vPos.insert( drawn.vPos.end(), di.pos.begin(), di.pos.end() );
+            drawn.vUV.insert( drawn.vUV.end(), di.uv.begin(), di.uv.end() );
+            drawn.vCol.insert( drawn.vCol.end(), di.tint.begin(), di.tint.end() );
+        }
+        engine.ClearDrawn();
+        return drawn;
+    }
+
+    // Proportional text as one quad per glyph at the pen position, from the metrics the font was
+    // made from - what the fonts drew before their drawing code was shared, expanded to the
+    // triangle lists the batches submit
+    Drawn Reference( const std::vector<olc::font::MetricsGlyph>& vGlyphs, float fLineHeight, const olc::vf2d& uvScale,
+                     const olc::vf2d& pos, const std::vector<uint32_t>& vText, const olc::Pixel col, const olc::vf2d& scale )
+    {
+        Drawn drawn;
+        olc::vf2d spos = { 0.0f, 0.0f };
+        for( uint32_t c : vText )
+        {
+            if( c == '\n' )
+            {
+                spos.x = 0.0f;
+                spos.y += fLineHeight * scale.y;
+                continue;
+            }
+
+            auto glyph = std::find_if( vGlyphs.begin(), vGlyphs.end(), [c]( auto& g ) { return g.nCodepoint == c; } );
+            const olc::vf2d source = { float( glyph->x ), float( glyph->y ) };
+            const olc::vf2d size = { float( glyph->w ), float( glyph->h ) };
+            const olc::vf2d tl = { std::floor( pos.x + spos.x ), std::floor( pos.y + spos.y ) };
+            const olc::vf2d br = tl + size * scale;
+            const olc::vf2d uvtl = source * uvScale, uvbr = ( source + size ) * uvScale;
+            const olc::vf2d corner[4] = { tl, { tl.x, br.y }, br, { br.x, tl.y } };
+            const olc::vf2d uv[4] = { uvtl, { uvtl.x, uvbr.y }, uvbr, { uvbr.x, uvtl.y } };
+            for( int k : { 0, 1, 2, 0, 2, 3 } )
+            {
+                drawn.vPos.push_back( corner[k] );
+                drawn.vUV.push_back( uv[k] );
+                drawn.vCol.push_back( col );
+            }
+            spos.x += float( glyph->nAdvance ) * scale.x;
+        }
+        return drawn;
+    }
+
+    // The drawing paths of a font against each other and against Reference()
+    template<class TFont>
+    void CheckFont( const std::string& name, TFont& font, TFont& embedded, const std::vector<olc::font::MetricsGlyph>& vGlyphs,
+                    const olc::vf2d& uvScale, const std::string& sText, olc::PixelGameEngine& engine )
+    {
+        const olc::vf2d pos = { 13.5f, 7.25f }, scale = { 2.0f, 1.5f };
+        const olc::Pixel col = olc::Pixel( 200, 100, 50, 255 );
+        std::vector<uint32_t> vText;
+        auto text = TFont::TextDecoder::Decode( sText, vText );
+
+        const Drawn reference = Reference( vGlyphs, float( font.GetTextSize( "" ).y ), uvScale, pos, std::vector<uint32_t>( text.begin(), text.end() ), col, scale );
+        const Drawn prop = Capture( engine, [&] { font.DrawStringPropDecal( pos, sText, col, scale ); } );
+        Check( name + "/prop_decal_matches_reference", prop == reference );
+        Check( name + "/embedded_metrics_match_metrics_file", Capture( engine, [&] { embedded.DrawStringPropDecal( pos, sText, col, scale ); } ) == prop );
+        Check( name + "/mono_embedded_metrics_match_metrics_file", Capture( engine, [&] { embedded.DrawStringDecal( pos, sText, col, scale ); } ) ==
+                                                                   Capture( engine, [&] { font.DrawStringDecal( pos, sText, col, scale ); } ) );
+
+        olc::TextLayout layout = font.LayoutText( sText, true );
+        Check( name + "/layout_decal_matches_string", Capture( engine, [&] { font.DrawStringDecal( pos, layout, col, scale ); } ) == prop );
+
+        olc::TextLabel label;
+        label.pos = pos;
+        label.sText = sText;
+        label.col = col;
+        label.scale = scale;
+        std::vector<olc::TextLabel> vLabels( 200, label );
+        font.SetLayoutThreads( 1 );
+        const Drawn labels = Capture( engine, [&] { font.DrawLabelsDecal( vLabels ); } );
+        font.SetLayoutThreads( 4 );
+        Check( name + "/labels_match_across_threads", Capture( engine, [&] { font.DrawLabelsDecal( vLabels ); } ) == labels );
+        font.SetLayoutThreads( 1 );
+        Check( name + "/label_matches_string", Capture( engine, [&] { font.DrawLabelsDecal( &label, 1 ); } ) == prop );
+
+        const Drawn rotated = Capture( engine, [&] { font.DrawRotatedStringPropDecal( pos, sText, 0.7f, { 3.0f, 4.0f }, col, scale ); } );
+        Check( name + "/rotated_layout_matches_string", Capture( engine, [&] { font.DrawRotatedStringDecal( pos, layout, 0.7f, { 3.0f, 4.0f }, col, scale ); } ) == rotated );
+
+        olc::Sprite a( 400, 200 ), b( 400, 200 );
+        font.DrawStringProp( &a, { 3, 5 }, sText, col, 2 );
+        font.DrawString( &b, { 3, 5 }, layout, col, 2 );
+        Check( name + "/sprite_layout_matches_string", a.pColData == b.pColData );
+    }
+
+    // Drawing numbers, formatted text and string_views must not allocate once the font's buffers
+    // have grown to fit them
+    template<class TFont>
+    void CheckAllocations( const std::string& name, TFont& font, olc::PixelGameEngine& engine )
+    {
+        const std::string sText = "Score 1200 / 3400";
+        const std::string_view svText( sText );
+        auto allocations = [&]( const std::function<void()>& draw )
+        {
+            draw();
+            const size_t nBefore = nAllocations.load();
+            for( int i = 0; i < 100; i++ )
+                draw();
+            return nAllocations.load() - nBefore;
+        };
+
+        engine.bRecord = false;
+        const float fScore = 1234.5f;
+        const std::function<void()> number = [&] { font.DrawNumberDecal( { 4.0f, 4.0f }, fScore ); };
+        const std::function<void()> formatted = [&] { font.DrawFormattedDecal( { 4.0f, 4.0f }, olc::WHITE, "FPS ", 60, " dt ", olc::font::Fixed{ 16.6667, 2 }, " x ", fScore ); };
+        const std::function<void()> view = [&] { font.DrawStringDecal( { 4.0f, 4.0f }, svText ); font.DrawStringPropDecal( { 4.0f, 24.0f }, svText ); };
+        const size_t nNumber = allocations( number ), nFormatted = allocations( formatted ), nView = allocations( view );
+        engine.bRecord = true;
+
+        Check( name + "/draw_number_decal_allocation_free", nNumber == 0 );
+        Check( name + "/draw_formatted_decal_allocation_free", nFormatted == 0 );
+        Check( name + "/draw_string_view_decal_allocation_free", nView == 0 );
+    }
+
+    void RunChecks()
+    {
+        olc::PixelGameEngine engine;
+        Engine::Attach( &engine );
+
+        std::vector<olc::font::MetricsGlyph> vAscii;
+        const std::string sAscii = MakeAsciiFont( "check_ascii.png", true, &vAscii );
+        olc::Font font( sAscii );
+        olc::Font fontEmbedded( MakeAsciiFont( "check_ascii_embedded.png", false ) );
+        const olc::vf2d asciiUV = { 1.0f / float( 16 * 14 ), 1.0f / float( 6 * 18 + 1 ) };
+        CheckFont( "check/font", font, fontEmbedded, vAscii, asciiUV, "Hello, World!\n[INFO] 100/100 {}~\nlast line", engine );
+        CheckAllocations( "check/font", font, engine );
+
+        std::vector<uint32_t> vCodepoints;
+        for( uint32_t c = 32; c < 127; c++ ) vCodepoints.push_back( c );
+        for( uint32_t c = 0x3041; c < 0x3097; c++ ) vCodepoints.push_back( c );
+        std::vector<olc::font::MetricsGlyph> vCustom;
+        olc::CustomFont custom( MakeCustomFont( "check_custom.png", vCodepoints, true, &vCustom ) );
+        olc::CustomFont customEmbedded( MakeCustomFont( "check_custom_embedded.png", vCodepoints, false ) );
+        const int per = int( std::ceil( std::sqrt( double( vCodepoints.size() ) ) ) );
+        const int rows = ( int( vCodepoints.size() ) * 2 + 6 + per * 20 - 1 ) / ( per * 20 );
+        const olc::vf2d customUV = { 1.0f / float( per * 20 ), 1.0f / float( per * 22 + rows ) };
+        CheckAllocations( "check/customfont", custom, engine );
+        CheckFont( "check/customfont", custom, customEmbedded, vCustom, customUV, "Hello \xE3\x81\x93\xE3\x82\x93\xE3\x81\xAB\xE3\x81\xA1\xE3\x81\xAF\nWorld", engine );
+
+        // Monospaced text from a png with embedded metrics draws whole cells, so ink past a
+        // glyph's advance isn't cut off
+        auto wholeCells = []( const Drawn& drawn, float fCellWidth )
+        {
+            for( size_t i = 0; i + 6 <= drawn.vPos.size(); i += 6 )
+                if( drawn.vPos[i + 2].x - drawn.vPos[i].x != fCellWidth )
+                    return false;
+            return !drawn.vPos.empty();
+        };
+        Check( "check/font/mono_embedded_draws_whole_cells",
+               wholeCells( Capture( engine, [&] { fontEmbedded.DrawStringDecal( { 13.5f, 7.25f }, "Hi, il", olc::WHITE, { 2.0f, 1.5f } ); } ), 14.0f * 2.0f ) );
+        Check( "check/customfont/mono_embedded_draws_whole_cells",
+               wholeCells( Capture( engine, [&] { customEmbedded.DrawStringDecal( { 13.5f, 7.25f }, "Hi, \xE3\x81\x93\xE3\x82\x93", olc::WHITE, { 2.0f, 1.5f } ); } ), 20.0f * 2.0f ) );
+
+        // A font created where a destroyed one lived doesn't get the old font's cached strings
+        olc::TextCache cache;
+        std::optional<olc::Font> reused;
+        reused.emplace( sAscii );
+        cache.DrawStringPropDecal( *reused, { 1.0f, 1.0f }, "cached" );
+        reused.emplace( sAscii );
+        cache.DrawStringPropDecal( *reused, { 1.0f, 1.0f }, "cached" );
+        cache.DrawStringPropDecal( *reused, { 1.0f, 1.0f }, "cached" );
+        Check( "check/textcache/new_font_at_old_address_misses", cache.GetStats().nMisses == 2 && cache.GetStats().nHits == 1 );
+        cache.ReleaseFont( *reused );
+        Check( "check/textcache/release_font_drops_its_strings", cache.GetStats().nEntries == 1 );
+
+        // A chain of one font draws what the font draws
+        olc::FontChain chain;
+        chain.Add( custom );
+        const std::string sChained = "Hello \xE3\x81\x93\xE3\x82\x93\nWorld \xE3\x81\xAB";
+        const Drawn chained = Capture( engine, [&] { chain.DrawStringPropDecal( { 13.5f, 7.25f }, sChained, olc::RED, { 2.0f, 1.5f } ); } );
+        Check( "check/fontchain/prop_decal_matches_font", chained == Capture( engine, [&] { custom.DrawStringPropDecal( { 13.5f, 7.25f }, sChained, olc::RED, { 2.0f, 1.5f } ); } ) );
+        Check( "check/fontchain/text_size_matches_font", chain.GetTextSizeProp( sChained ) == custom.GetTextSizeProp( sChained ) &&
+                                                         chain.GetTextSize( sChained ) == custom.GetTextSize( sChained ) );
+
+        // Fonts of different heights share a baseline: the bottom of their cells, or the rows given to Add()
+        const olc::vf2d chainPos = { 13.5f, 7.25f }, chainScale = { 2.0f, 1.5f };
+        const uint32_t vLatin[] = { 'H', 'i', ' ' };
+        const float fLatin = font.GetCodepointsAdvance( std::begin( vLatin ), std::end( vLatin ), true );
+        const int nFontHeight = font.GetTextSize( "" ).y, nCustomHeight = custom.GetTextSize( "" ).y;
+        auto mixed = [&]( int nFontOffset, int nCustomOffset )
+        {
+            return Capture( engine, [&]
+            {
+                font.DrawStringPropDecal( chainPos + olc::vf2d( 0.0f, float( nFontOffset ) ) * chainScale, "Hi ", olc::RED, chainScale );
+                custom.DrawStringPropDecal( chainPos + olc::vf2d( fLatin, float( nCustomOffset ) ) * chainScale, "\xE3\x81\x93\xE3\x82\x93", olc::RED, chainScale );
+            } );
+        };
+        const std::string sMixed = "Hi \xE3\x81\x93\xE3\x82\x93";
+        olc::FontChain bottoms;
+        bottoms.Add( font );
+        bottoms.Add( custom );
+        const int nTallest = std::max( nFontHeight, nCustomHeight );
+        Check( "check/fontchain/mixed_heights_share_cell_bottoms", nFontHeight != nCustomHeight &&
+               Capture( engine, [&] { bottoms.DrawStringPropDecal( chainPos, sMixed, olc::RED, chainScale ); } ) == mixed( nTallest - nFontHeight, nTallest - nCustomHeight ) &&
+               bottoms.GetTextSizeProp( sMixed ).y == nTallest );
+        olc::FontChain baselines;
+        baselines.Add( font, nFontHeight - 4 );
+        baselines.Add( custom, nCustomHeight - 2 );
+        const int nLineBaseline = std::max( nFontHeight - 4, nCustomHeight - 2 );
+        const int nFontOffset = nLineBaseline - ( nFontHeight - 4 ), nCustomOffset = nLineBaseline - ( nCustomHeight - 2 );
+        Check( "check/fontchain/mixed_heights_share_given_baselines",
+               Capture( engine, [&] { baselines.DrawStringPropDecal( chainPos, sMixed, olc::RED, chainScale ); } ) == mixed( nFontOffset, nCustomOffset ) &&
+               baselines.GetTextSizeProp( sMixed ).y == std::max( nFontOffset + nFontHeight, nCustomOffset + nCustomHeight ) );
+    }
+
+
+    // ---------------------------------------------------------------------------------------
+    // Output
+
+    std::string Escape( const std::string& s )
+    {
+        std::string r;
+        for( char c : s )
+        {
+            if( c == '"' || c == '\\' ) r += '\\';
+            r += c;
+        }
+        return r;
+    }
+
+    const char* SimdPath()
+    {
+#if defined(__AVX2__)
+        return "avx2";
+#elif defined(__AVX__)
+        return "avx";
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        return "sse2";
+#else
+        return "scalar";
+#endif
+    }
+
+    void WriteJson( FILE* out )
+    {
+        fprintf( out, "{\n  \"context\": {\n" );
+        fprintf( out, "    \"simd\": \"%s\",\n", SimdPath() );
+#if defined(NDEBUG)
+        fprintf( out, "    \"build\": \"release\",\n" );
+#else
+        fprintf( out, "    \"build\": \"debug\",\n" );
+#endif
+        fprintf( out, "    \"min_time_s\": %g\n  },\n  \"benchmarks\": [\n", options.fMinTime );
+        for( size_t i = 0; i < vResults.size(); i++ )
+        {
+            const Result& r = vResults[i];
+            fprintf( out, "    { \"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, \"items_per_second\": %.1f, \"items\": \"%s\"",
+                     Escape( r.name ).c_str(), (unsigned long long)r.nIterations, r.fNsPerOp, r.fItemsPerSecond, r.sItems.c_str() );
+            for( auto& [counter, value] : r.vCounters )
+                fprintf( out, ", \"%s\": %g", counter.c_str(), value );
+            fprintf( out, " }%s\n", i + 1 < vResults.size() ? "," : "" );
+        }
+        fprintf( out, "  ]\n}\n" );
+    }
+}
+
+
+int main( int argc, char* argv[] )
+{
+    bool bCheck = false;
+    for( int i = 1; i < argc; i++ )
+    {
+        std::string arg = argv[i];
+        if( arg == "--check" ) bCheck = true;
+        else if( arg == "--filter" && i + 1 < argc ) options.sFilter = argv[++i];
+        else if( arg == "--out" && i + 1 < argc ) options.sOut = argv[++i];
+        else if( arg == "--min-time" && i + 1 < argc ) options.fMinTime = std::atof( argv[++i] );
+        else
+        {
+            fprintf( stderr, "usage: %s [--filter <substring>] [--out <file.json>] [--min-time <seconds>] | --check\n", argv[0] );
+            return 1;
+        }
+    }
+
+    if( bCheck )
+    {
+        RunChecks();
+        return nFailures == 0 ? 0 : 1;
+    }
+
+    BenchDecode();
+    BenchFont();
+    BenchCustomFont();
+    BenchTextBox();
+    BenchLoad();
+
+    FILE* out = options.sOut.empty() ? stdout : fopen( options.sOut.c_str(), "w" );
+    if( out == nullptr )
+    {
+        fprintf( stderr, "unable to write %s\n", options.sOut.c_str() );
+        return 1;
+    }
+    WriteJson( out );
+    if( out != stdout )
+        fclose( out );
+    return 0;
+}
@@ -0,0 +1,265 @@
+// Headless stand-in for olcPixelGameEngine.h, used only by the benchmarks.
+//
+// It declares just the parts of the engine the font extensions use. Nothing is rendered:
+// decals drawn through the engine are recorded (and counted) so the benchmarks can check
+// and measure what was submitted. Sprites are "loaded" from an in-memory registry of images
+// rather than decoded from disk, see Sprite::Register().
+//
+// The OLC_PGE_DEF guard matches the real header's, so if a real olcPixelGameEngine.h is on the
+// include path as well, whichever is included first wins and the other is skipped.
+
+#pragma once
+#ifndef OLC_PGE_DEF
+#define OLC_PGE_DEF
+
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <streambuf>
+
+namespace olc
+{
+    enum rcode { FAIL = 0, OK = 1, NO_FILE = -1 };
+
+    struct Pixel
+    {
+        union { uint32_t n = 0xFF000000; struct { uint8_t r; uint8_t g; uint8_t b; uint8_t a; }; };
+        enum Mode { NORMAL, MASK, ALPHA, CUSTOM };
+
+        Pixel() = default;
+        Pixel(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha = 255) { r = red; g = green; b = blue; a = alpha; }
+        Pixel(uint32_t p) { n = p; }
+        bool operator==(const Pixel& p) const { return n == p.n; }
+        bool operator!=(const Pixel& p) const { return n != p.n; }
+    };
+
+    static const Pixel
+        WHITE(255, 255, 255), BLACK(0, 0, 0), RED(255, 0, 0), YELLOW(255, 255, 0), GREEN(0, 255, 0), BLUE(0, 0, 255),
+        DARK_GREEN(0, 128, 0), DARK_GREY(64, 64, 64), BLANK(0, 0, 0, 0);
+
+    template <class T>
+    struct v2d_generic
+    {
+        T x = 0;
+        T y = 0;
+        v2d_generic() = default;
+        v2d_generic(T _x, T _y) : x(_x), y(_y) {}
+        v2d_generic operator+(const v2d_generic& r) const { return { x + r.x, y + r.y }; }
+        v2d_generic operator-(const v2d_generic& r) const { return { x - r.x, y - r.y }; }
+        v2d_generic operator*(const T& r) const { return { x * r, y * r }; }
+        v2d_generic operator*(const v2d_generic& r) const { return { x * r.x, y * r.y }; }
+        v2d_generic operator/(const T& r) const { return { x / r, y / r }; }
+        v2d_generic operator/(const v2d_generic& r) const { return { x / r.x, y / r.y }; }
+        v2d_generic& operator+=(const v2d_generic& r) { x += r.x; y += r.y; return *this; }
+        v2d_generic& operator-=(const v2d_generic& r) { x -= r.x; y -= r.y; return *this; }
+        v2d_generic& operator*=(const T& r) { x *= r; y *= r; return *this; }
+        bool operator==(const v2d_generic& r) const { return x == r.x && y == r.y; }
+        bool operator!=(const v2d_generic& r) const { return x != r.x || y != r.y; }
+        operator v2d_generic<int32_t>() const { return { static_cast<int32_t>(x), static_cast<int32_t>(y) }; }
+        operator v2d_generic<float>() const { return { static_cast<float>(x), static_cast<float>(y) }; }
+    };
+    typedef v2d_generic<int32_t> vi2d;
+    typedef v2d_generic<float> vf2d;
+
+    struct ResourceBuffer : public std::streambuf
+    {
+        std::vector<char> vMemory;
+    };
+
+    // Resource packs aren't benchmarked - this one never contains anything
+    class ResourcePack
+    {
+    public:
+        ResourceBuffer GetFileBuffer(const std::string&) { return ResourceBuffer(); }
+        bool Loaded() { return true; }
+    };
+
+    class Sprite
+    {
+    public:
+        Sprite() = default;
+        Sprite(const std::string& sImageFile, olc::ResourcePack* pack = nullptr) { LoadFromFile(sImageFile, pack); }
+        Sprite(int32_t w, int32_t h) : width(w), height(h) { pColData.resize(size_t(w) * size_t(h), Pixel(0, 0, 0, 0)); }
+
+        olc::rcode LoadFromFile(const std::string& sImageFile, olc::ResourcePack* = nullptr)
+        {
+            std::shared_ptr<const Sprite> image;
+            {
+                std::lock_guard<std::mutex> lock(RegistryMutex());
+                auto it = Registry().find(sImageFile);
+                if (it == Registry().end()) return olc::NO_FILE;
+                image = it->second;
+            }
+            width = image->width; height = image->height; pColData = image->pColData;
+            return olc::OK;
+        }
+
+        Pixel GetPixel(int32_t x, int32_t y) const
+        {
+            if (x >= 0 && x < width && y >= 0 && y < height) return pColData[size_t(y) * width + x];
+            return Pixel(0, 0, 0, 0);
+        }
+        Pixel GetPixel(const vi2d& a) const { return GetPixel(a.x, a.y); }
+        bool SetPixel(int32_t x, int32_t y, Pixel p)
+        {
+            if (x >= 0 && x < width && y >= 0 && y < height) { pColData[size_t(y) * width + x] = p; return true; }
+            return false;
+        }
+        Pixel* GetData() { return pColData.data(); }
+
+        // Stub only: makes 'image' loadable as sImageFile
+        static void Register(const std::string& sImageFile, const Sprite& image)
+        {
+            std::lock_guard<std::mutex> lock(RegistryMutex());
+            Registry()[sImageFile] = std::make_shared<const Sprite>(image);
+        }
+
+    public:
+        int32_t width = 0;
+        int32_t height = 0;
+        std::vector<Pixel> pColData;
+
+    private:
+        static std::map<std::string, std::shared_ptr<const Sprite>>& Registry() { static std::map<std::string, std::shared_ptr<const Sprite>> m; return m; }
+        static std::mutex& RegistryMutex() { static std::mutex m; return m; }
+    };
+
+    enum class DecalMode { NORMAL, ADDITIVE, MULTIPLICATIVE, STENCIL, ILLUMINATE, WIREFRAME, MODEL3D };
+    enum class DecalStructure { LINE, FAN, STRIP, LIST };
+
+    class Decal
+    {
+    public:
+        Decal(olc::Sprite* spr, bool filter = false, bool clamp = true)
+        {
+            (void)filter; (void)clamp;
+            sprite = spr;
+            Update();
+        }
+        void Update()
+        {
+            if (sprite && sprite->width && sprite->height)
+                vUVScale = { 1.0f / float(sprite->width), 1.0f / float(sprite->height) };
+        }
+        void UpdateSprite() {}
+
+    public:
+        int32_t id = 1;
+        olc::Sprite* sprite = nullptr;
+        olc::vf2d vUVScale = { 1.0f, 1.0f };
+    };
+
+    struct DecalInstance
+    {
+        olc::Decal* decal = nullptr;
+        std::vector<olc::vf2d> pos;
+        std::vector<olc::vf2d> uv;
+        std::vector<olc::Pixel> tint;
+        uint32_t points = 0;
+        olc::DecalStructure structure = olc::DecalStructure::FAN;
+    };
+
+    class PixelGameEngine
+    {
+    public:
+        int32_t ScreenWidth() const { return vScreenSize.x; }
+        int32_t ScreenHeight() const { return vScreenSize.y; }
+        const olc::vi2d& GetScreenSize() const { return vScreenSize; }
+
+        void SetDecalMode(const olc::DecalMode&) {}
+        void SetDecalStructure(const olc::DecalStructure& structure) { nDecalStructure = structure; }
+
+        void DrawDecal(const olc::vf2d& pos, olc::Decal* decal, const olc::vf2d& scale = { 1.0f, 1.0f }, const olc::Pixel& tint = olc::WHITE)
+        {
+            DrawPartialDecal(pos, decal, { 0.0f, 0.0f }, { float(decal->sprite->width), float(decal->sprite->height) }, scale, tint);
+        }
+
+        void DrawPartialDecal(const olc::vf2d& pos, olc::Decal* decal, const olc::vf2d& source_pos, const olc::vf2d& source_size,
+                              const olc::vf2d& scale = { 1.0f, 1.0f }, const olc::Pixel& tint = olc::WHITE)
+        {
+            olc::vf2d p = { std::floor(pos.x), std::floor(pos.y) };
+            olc::vf2d s = source_size * scale;
+            olc::vf2d vPos[4] = { p, { p.x, p.y + s.y }, p + s, { p.x + s.x, p.y } };
+            olc::vf2d uvtl = source_pos * decal->vUVScale, uvbr = uvtl + source_size * decal->vUVScale;
+            olc::vf2d vUV[4] = { uvtl, { uvtl.x, uvbr.y }, uvbr, { uvbr.x, uvtl.y } };
+            olc::Pixel vCol[4] = { tint, tint, tint, tint };
+            Record(decal, vPos, vUV, vCol, 4, olc::DecalStructure::FAN);
+        }
+
+        void DrawRotatedDecal(const olc::vf2d& pos, olc::Decal* decal, const float fAngle, const olc::vf2d& center = { 0.0f, 0.0f },
+                              const olc::vf2d& scale = { 1.0f, 1.0f }, const olc::Pixel& tint = olc::WHITE)
+        {
+            DrawPartialRotatedDecal(pos, decal, fAngle, center, { 0.0f, 0.0f }, { float(decal->sprite->width), float(decal->sprite->height) }, scale, tint);
+        }
+
+        void DrawPartialRotatedDecal(const olc::vf2d& pos, olc::Decal* decal, const float fAngle, const olc::vf2d& center, const olc::vf2d& source_pos,
+                                     const olc::vf2d& source_size, const olc::vf2d& scale = { 1.0f, 1.0f }, const olc::Pixel& tint = olc::WHITE)
+        {
+            olc::vf2d vPos[4] = { (olc::vf2d(0, 0) - center) * scale, (olc::vf2d(0, source_size.y) - center) * scale,
+                                  (source_size - center) * scale, (olc::vf2d(source_size.x, 0) - center) * scale };
+            float c = std::cos(fAngle), s = std::sin(fAngle);
+            for (auto& v : vPos) v = pos + olc::vf2d(v.x * c - v.y * s, v.x * s + v.y * c);
+            olc::vf2d uvtl = source_pos * decal->vUVScale, uvbr = uvtl + source_size * decal->vUVScale;
+            olc::vf2d vUV[4] = { uvtl, { uvtl.x, uvbr.y }, uvbr, { uvbr.x, uvtl.y } };
+            olc::Pixel vCol[4] = { tint, tint, tint, tint };
+            Record(decal, vPos, vUV, vCol, 4, olc::DecalStructure::FAN);
+        }
+
+        void DrawExplicitDecal(olc::Decal* decal, const olc::vf2d* pos, const olc::vf2d* uv, const olc::Pixel* col, uint32_t elements = 4)
+        {
+            Record(decal, pos, uv, col, elements, nDecalStructure);
+        }
+
+    public:
+        // Stub only: what has been drawn since the last ClearDrawn()
+        void ClearDrawn() { vDecalInstances.clear(); nInstances = 0; nVertices = 0; }
+        bool                        bRecord = true;     // keep the instances, or only count them
+        std::vector<DecalInstance>  vDecalInstances;
+        size_t                      nInstances = 0;
+        size_t                      nVertices = 0;
+        olc::vi2d                   vScreenSize = { 1280, 720 };
+
+    private:
+        void Record(olc::Decal* decal, const olc::vf2d* pos, const olc::vf2d* uv, const olc::Pixel* col, uint32_t elements, olc::DecalStructure structure)
+        {
+            nInstances++;
+            nVertices += elements;
+            if (!bRecord) return;
+            DecalInstance di;
+            di.decal = decal;
+            di.pos.assign(pos, pos + elements);
+            di.uv.assign(uv, uv + elements);
+            di.tint.assign(col, col + elements);
+            di.points = elements;
+            di.structure = structure;
+            vDecalInstances.push_back(std::move(di));
+        }
+
+        olc::DecalStructure nDecalStructure = olc::DecalStructure::FAN;
+    };
+
+    class PGEX
+    {
+        friend class olc::PixelGameEngine;
+    public:
+        PGEX(bool bHook = false) { (void)bHook; }
+
+    protected:
+        virtual void OnBeforeUserCreate() {}
+        virtual void OnAfterUserCreate() {}
+        virtual bool OnBeforeUserUpdate(float&) { return false; }
+        virtual void OnAfterUserUpdate(float) {}
+
+    protected:
+        static PixelGameEngine* pge;
+    };
+
+    inline PixelGameEngine* PGEX::pge = nullptr;
+}
+
+#endif
@@ -0,0 +1,628 @@
+// Checks of olcPGEX_TrueType.h, run by ctest.
+//
+// A small truetype font is built in memory - squares, a triangle, a ring with a hole, a circle of
+// quadratic curves and a composite of two of them - and each glyph is rasterised at a few sizes
+// and compared with a reference bitmap: the exact area of each pixel inside the outline, from the
+// outline flattened much finer than the rasteriser does and clipped against every pixel. The
+// lookups, the metrics, collections and both 'loca' formats are checked on the way.
+//
+// Then the font is truncated at every length and has bytes overwritten at random, and every
+// glyph of every copy is looked up and rasterised: nothing may be read outside the font data
+// (build with -fsanitize=address to have that checked, not just survived).
+//
+//     truetype_check
+
+#include "../olcPGEX_TrueType.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace ttf = olc::font::ttf;
+
+namespace
+{
+    int nFailures = 0;
+
+    void Check( const std::string& name, bool bPassed, const std::string& sDetail = "" )
+    {
+        fprintf( stderr, "%-56s %s %s\n", name.c_str(), bPassed ? "ok" : "FAILED", bPassed ? "" : sDetail.c_str() );
+        nFailures += bPassed ? 0 : 1;
+    }
+
+    // ---------------------------------------------------------------------------------------
+    // The test font
+
+    struct Point
+    {
+        double x, y;
+        bool bOn;
+    };
+
+    typedef std::vector<Point> Contour;
+
+    struct Component
+    {
+        int nGlyph;
+        int dx, dy;
+        double fScale;
+    };
+
+    struct TestGlyph
+    {
+        std::vector<Contour>    vContours;      // a simple glyph
+        std::vector<Component>  vComponents;    // or a composite
+        int                     nAdvance;
+        int                     nBearing;
+        int                     x0, y0, x1, y1; // the box stored with it, font units
+    };
+
+    constexpr int UNITS_PER_EM = 1000, ASCENT = 800, DESCENT = -200, LINE_GAP = 90;
+
+    // The outline of a glyph in font units, composites expanded
+    std::vector<Contour> Expand( const std::vector<TestGlyph>& vGlyphs, int nGlyph )
+    {
+        const TestGlyph& g = vGlyphs[size_t( nGlyph )];
+        std::vector<Contour> vOut = g.vContours;
+        for( auto& c : g.vComponents )
+            for( Contour contour : Expand( vGlyphs, c.nGlyph ) )
+            {
+                for( auto& p : contour )
+                {
+                    p.x = p.x * c.fScale + c.dx;
+                    p.y = p.y * c.fScale + c.dy;
+                }
+                vOut.push_back( contour );
+            }
+        return vOut;
+    }
+
+    void Box( TestGlyph& g, const std::vector<TestGlyph>& vGlyphs, int nGlyph )
+    {
+        g.x0 = g.y0 = 32767;
+        g.x1 = g.y1 = -32768;
+        for( auto& contour : Expand( vGlyphs, nGlyph ) )
+            for( auto& p : contour )
+            {
+                g.x0 = std::min( g.x0, int( std::floor( p.x ) ) );
+                g.y0 = std::min( g.y0, int( std::floor( p.y ) ) );
+                g.x1 = std::max( g.x1, int( std::ceil( p.x ) ) );
+                g.y1 = std::max( g.y1, int( std::ceil( p.y ) ) );
+            }
+        g.nBearing = g.x0;
+    }
+
+    // Clockwise, as truetype outer contours are
+    Contour Rect( double x0, double y0, double x1, double y1 )
+    {
+        return { { x0, y0, true }, { x0, y1, true }, { x1, y1, true }, { x1, y0, true } };
+    }
+
+    std::vector<TestGlyph> TestGlyphs()
+    {
+        std::vector<TestGlyph> v( 7 );
+        v[1].vContours = { Rect( 100, 0, 600, 700 ) };                                          // a square
+        v[2].vContours = { { { 50, -150, true }, { 420, 760, true }, { 810, -150, true } } };   // a triangle below the baseline
+
+        // A ring: the inner contour runs the other way
+        Contour inner = Rect( 250, 150, 550, 450 );
+        std::reverse( inner.begin(), inner.end() );
+        v[3].vContours = { Rect( 100, 0, 700, 600 ), inner };
+
+        // A circle of 8 control points only, so every on curve point is implied
+        Contour circle;
+        for( int i = 0; i < 8; i++ )
+        {
+            const double a = -i * 3.14159265358979 / 4.0, r = 300.0 / std::cos( 3.14159265358979 / 8.0 );
+            circle.push_back( { 400 + r * std::cos( a ), 350 + r * std::sin( a ), false } );
+        }
+        v[4].vContours = { circle };
+
+        // Curves between on curve points, and a run of control points
+        v[5].vContours = { { { 100, 0, true }, { 100, 400, false }, { 500, 700, true }, { 700, 500, false }, { 800, 300, false }, { 600, 0, true } } };
+
+        // The square moved right, the circle halved and moved up
+        v[6].vComponents = { { 1, 700, 0, 1.0 }, { 4, 0, 400, 0.5 } };
+
+        // The font only holds whole units
+        for( auto& g : v )
+            for( auto& contour : g.vContours )
+                for( auto& p : contour )
+                {
+                    p.x = std::round( p.x );
+                    p.y = std::round( p.y );
+                }
+
+        for( int i = 1; i < int( v.size() ); i++ )
+        {
+            Box( v[size_t( i )], v, i );
+            v[size_t( i )].nAdvance = 900 + i * 10;
+        }
+        v[0].nAdvance = 500;
+        return v;
+    }
+
+    // Big endian writing
+    struct Writer
+    {
+        std::vector<uint8_t> v;
+        void U8( int n )        { v.push_back( uint8_t( n ) ); }
+        void U16( int n )       { U8( n >> 8 ); U8( n ); }
+        void U32( uint32_t n )  { U16( int( n >> 16 ) ); U16( int( n & 0xFFFF ) ); }
+        void Pad()              { while( v.size() % 4 ) U8( 0 ); }
+    };
+
+    std::vector<uint8_t> SimpleGlyph( const TestGlyph& g )
+    {
+        Writer w;
+        std::vector<Point> vPoints;
+        w.U16( int( g.vContours.size() ) );
+        w.U16( g.x0 ); w.U16( g.y0 ); w.U16( g.x1 ); w.U16( g.y1 );
+        for( auto& contour : g.vContours )
+        {
+            vPoints.insert( vPoints.end(), contour.begin(), contour.end() );
+            w.U16( int( vPoints.size() ) - 1 );
+        }
+        w.U16( 0 );     // no instructions
+
+        // Short deltas where they fit, repeated flags where they repeat, as fonts are stored
+        std::vector<int> vFlags, vDx, vDy;
+        int px = 0, py = 0;
+        for( auto& p : vPoints )
+        {
+            const int x = int( std::lround( p.x ) ), y = int( std::lround( p.y ) ), dx = x - px, dy = y - py;
+            int nFlags = p.bOn ? 1 : 0;
+            if( dx == 0 )                   nFlags |= 16;
+            else if( std::abs( dx ) < 256 ) nFlags |= 2 | ( dx > 0 ? 16 : 0 );
+            if( dy == 0 )                   nFlags |= 32;
+            else if( std::abs( dy ) < 256 ) nFlags |= 4 | ( dy > 0 ? 32 : 0 );
+            vFlags.push_back( nFlags ); vDx.push_back( dx ); vDy.push_back( dy );
+            px = x; py = y;
+        }
+        for( size_t i = 0; i < vFlags.size(); )
+        {
+            size_t n = 1;
+            while( i + n < vFlags.size() && vFlags[i + n] == vFlags[i] && n < 255 ) n++;
+            if( n > 1 ) { w.U8( vFlags[i] | 8 ); w.U8( int( n - 1 ) ); }
+            else        w.U8( vFlags[i] );
+            i += n;
+        }
+        for( size_t i = 0; i < vFlags.size(); i++ )
+        {
+            if( vFlags[i] & 2 )             w.U8( std::abs( vDx[i] ) );
+            else if( !( vFlags[i] & 16 ) )  w.U16( vDx[i] );
+        }
+        for( size_t i = 0; i < vFlags.size(); i++ )
+        {
+            if( vFlags[i] & 4 )             w.U8( std::abs( vDy[i] ) );
+            else if( !( vFlags[i] & 32 ) )  w.U16( vDy[i] );
+        }
+        return w.v;
+    }
+
+    std::vector<uint8_t> CompositeGlyph( const TestGlyph& g )
+    {
+        Writer w;
+        w.U16( -1 );
+        w.U16( g.x0 ); w.U16( g.y0 ); w.U16( g.x1 ); w.U16( g.y1 );
+        for( size_t i = 0; i < g.vComponents.size(); i++ )
+        {
+            const Component& c = g.vComponents[i];
+            const bool bScale = c.fScale != 1.0, bWords = c.dx < -128 || c.dx > 127 || c.dy < -128 || c.dy > 127;
+            w.U16( ( bWords ? 1 : 0 ) | 2 | ( bScale ? 8 : 0 ) | ( i + 1 < g.vComponents.size() ? 32 : 0 ) );
+            w.U16( c.nGlyph );
+            if( bWords ) { w.U16( c.dx ); w.U16( c.dy ); }
+            else         { w.U8( c.dx ); w.U8( c.dy ); }
+            if( bScale )
+                w.U16( int( std::lround( c.fScale * 16384.0 ) ) );
+        }
+        return w.v;
+    }
+
+    struct Mapping
+    {
+        uint32_t    nCodepoint;
+        int         nGlyph;
+    };
+
+    const std::vector<Mapping> vMappings = { { 'A', 1 }, { 'B', 2 }, { 'C', 3 }, { 'a', 4 }, { 'b', 5 }, { 'c', 6 }, { 0x1F600, 4 } };
+
+    std::vector<uint8_t> Cmap( bool bFormat12 )
+    {
+        Writer w;
+        w.U16( 0 ); w.U16( 1 );
+        if( bFormat12 )
+        {
+            // Groups of consecutive codepoints, microsoft unicode full repertoire
+            w.U16( 3 ); w.U16( 10 ); w.U32( 12 );
+            w.U16( 12 ); w.U16( 0 ); w.U32( 16 + 12 * uint32_t( vMappings.size() ) ); w.U32( 0 ); w.U32( uint32_t( vMappings.size() ) );
+            for( auto& m : vMappings )
+            {
+                w.U32( m.nCodepoint ); w.U32( m.nCodepoint ); w.U32( uint32_t( m.nGlyph ) );
+            }
+            return w.v;
+        }
+
+        // Segments: 'A'..'C' by delta, 'a'..'c' through the glyph id array, and the closing 0xFFFF
+        w.U16( 3 ); w.U16( 1 ); w.U32( 12 );
+        const int nSegments = 3;
+        w.U16( 4 ); w.U16( 16 + nSegments * 8 + 6 ); w.U16( 0 ); w.U16( nSegments * 2 ); w.U16( 4 ); w.U16( 1 ); w.U16( 2 );
+        w.U16( 'C' ); w.U16( 'c' ); w.U16( 0xFFFF );        // end codes
+        w.U16( 0 );
+        w.U16( 'A' ); w.U16( 'a' ); w.U16( 0xFFFF );        // start codes
+        w.U16( 1 - 'A' ); w.U16( 0 ); w.U16( 1 );           // deltas
+        w.U16( 0 ); w.U16( 4 ); w.U16( 0 );                 // range offsets: the second segment's is 2 entries away from the array
+        w.U16( 4 ); w.U16( 5 ); w.U16( 6 );                 // glyph ids of 'a'..'c'
+        return w.v;
+    }
+
+    struct FontOptions
+    {
+        bool    bLongLoca = false;
+        bool    bFormat12 = false;
+        bool    bCollection = false;        // wrapped in a .ttc header
+    };
+
+    std::vector<uint8_t> BuildFont( const std::vector<TestGlyph>& vGlyphs, const FontOptions& options )
+    {
+        // glyf and loca
+        Writer glyf, loca;
+        for( auto& g : vGlyphs )
+        {
+            if( options.bLongLoca ) loca.U32( uint32_t( glyf.v.size() ) );
+            else                    loca.U16( int( glyf.v.size() / 2 ) );
+            if( !g.vContours.empty() || !g.vComponents.empty() )
+            {
+                auto v = g.vComponents.empty() ? SimpleGlyph( g ) : CompositeGlyph( g );
+                glyf.v.insert( glyf.v.end(), v.begin(), v.end() );
+                while( glyf.v.size() % 4 ) glyf.U8( 0 );
+            }
+        }
+        if( options.bLongLoca ) loca.U32( uint32_t( glyf.v.size() ) );
+        else                    loca.U16( int( glyf.v.size() / 2 ) );
+
+        Writer head;
+        head.U32( 0x00010000 ); head.U32( 0 ); head.U32( 0 ); head.U32( 0x5F0F3CF5 ); head.U16( 0 ); head.U16( UNITS_PER_EM );
+        for( int i = 0; i < 4; i++ ) head.U32( 0 );
+        head.U16( -100 ); head.U16( -200 ); head.U16( 1600 ); head.U16( 900 );
+        head.U16( 0 ); head.U16( 8 ); head.U16( 2 ); head.U16( options.bLongLoca ? 1 : 0 ); head.U16( 0 );
+
+        // The last glyph shares the advance of the one before and only stores its bearing
+        const int nLongMetrics = int( vGlyphs.size() ) - 1;
+        Writer hhea;
+        hhea.U32( 0x00010000 ); hhea.U16( ASCENT ); hhea.U16( DESCENT ); hhea.U16( LINE_GAP ); hhea.U16( 2000 );
+        for( int i = 0; i < 11; i++ ) hhea.U16( 0 );
+        hhea.U16( nLongMetrics );
+
+        Writer hmtx;
+        for( int i = 0; i < int( vGlyphs.size() ); i++ )
+        {
+            if( i < nLongMetrics ) hmtx.U16( vGlyphs[size_t( i )].nAdvance );
+            hmtx.U16( vGlyphs[size_t( i )].nBearing );
+        }
+
+        Writer maxp;
+        maxp.U32( 0x00005000 ); maxp.U16( int( vGlyphs.size() ) );
+
+        // Tables in tag order, after the directory
+        std::vector<std::pair<std::string, std::vector<uint8_t>>> vTables = {
+            { "cmap", Cmap( options.bFormat12 ) }, { "glyf", glyf.v }, { "head", head.v }, { "hhea", hhea.v },
+            { "hmtx", hmtx.v }, { "loca", loca.v }, { "maxp", maxp.v } };
+
+        const uint32_t nBase = options.bCollection ? 16 : 0;
+        Writer font;
+        if( options.bCollection )
+        {
+            font.v.insert( font.v.end(), { 't', 't', 'c', 'f' } );
+            font.U32( 0x00010000 ); font.U32( 1 ); font.U32( nBase );
+        }
+        font.U32( 0x00010000 ); font.U16( int( vTables.size() ) ); font.U16( 0 ); font.U16( 0 ); font.U16( 0 );
+        uint32_t nOffset = nBase + 12 + 16 * uint32_t( vTables.size() );
+        for( auto& [sTag, vData] : vTables )
+        {
+            font.v.insert( font.v.end(), sTag.begin(), sTag.end() );
+            font.U32( 0 ); font.U32( nOffset ); font.U32( uint32_t( vData.size() ) );
+            nOffset += uint32_t( ( vData.size() + 3 ) / 4 * 4 );
+        }
+        for( auto& table : vTables )
+        {
+            font.v.insert( font.v.end(), table.second.begin(), table.second.end() );
+            font.Pad();
+        }
+        return font.v;
+    }
+
+    // ---------------------------------------------------------------------------------------
+    // The reference rasteriser
+
+    // A contour as a polygon: the quadratic curves cut into 256 lines each, on curve points
+    // implied between consecutive control points
+    std::vector<Point> Flatten( const Contour& contour )
+    {
+        std::vector<Point> vPoints;
+        const size_t n = contour.size();
+        size_t nStart = 0;
+        while( nStart < n && !contour[nStart].bOn ) nStart++;
+
+        // Start on an on curve point, or between the last and first control points if there is none
+        const bool bImplied = nStart == n;
+        const Point start = bImplied ? Point{ ( contour[0].x + contour[n - 1].x ) / 2, ( contour[0].y + contour[n - 1].y ) / 2, true } : contour[nStart];
+        const size_t nFirst = bImplied ? 0 : 1;
+
+        Point pen = start;
+        vPoints.push_back( pen );
+        const Point* pControl = nullptr;
+        auto curve = [&]( const Point& c, const Point& to )
+        {
+            for( int i = 1; i <= 256; i++ )
+            {
+                const double t = i / 256.0, u = 1.0 - t;
+                vPoints.push_back( { u * u * pen.x + 2 * u * t * c.x + t * t * to.x, u * u * pen.y + 2 * u * t * c.y + t * t * to.y, true } );
+            }
+            pen = to;
+        };
+        for( size_t i = nFirst; i < n; i++ )
+        {
+            const Point& p = contour[( nStart + i ) % n];
+            if( p.bOn )
+            {
+                if( pControl ) curve( *pControl, p );
+                else           { vPoints.push_back( p ); pen = p; }
+                pControl = nullptr;
+            }
+            else
+            {
+                if( pControl )
+                    curve( *pControl, { ( pControl->x + p.x ) / 2, ( pControl->y + p.y ) / 2, true } );
+                pControl = &p;
+            }
+        }
+        if( pControl ) curve( *pControl, start );
+        return vPoints;
+    }
+
+    // Signed area of a polygon clipped to the pixel [x, x+1] x [y, y+1]
+    double ClippedArea( const std::vector<Point>& vPolygon, double x, double y )
+    {
+        std::vector<Point> v = vPolygon, out;
+        auto clip = [&]( auto inside, auto cross )
+        {
+            out.clear();
+            for( size_t i = 0; i < v.size(); i++ )
+            {
+                const Point& a = v[i];
+                const Point& b = v[( i + 1 ) % v.size()];
+                if( inside( a ) )
+                {
+                    out.push_back( a );
+                    if( !inside( b ) ) out.push_back( cross( a, b ) );
+                }
+                else if( inside( b ) )
+                    out.push_back( cross( a, b ) );
+            }
+            v.swap( out );
+        };
+        auto atX = [&]( double cx ) { return [cx]( const Point& a, const Point& b ) { double t = ( cx - a.x ) / ( b.x - a.x ); return Point{ cx, a.y + t * ( b.y - a.y ), true }; }; };
+        auto atY = [&]( double cy ) { return [cy]( const Point& a, const Point& b ) { double t = ( cy - a.y ) / ( b.y - a.y ); return Point{ a.x + t * ( b.x - a.x ), cy, true }; }; };
+        clip( [x]( const Point& p ) { return p.x >= x; }, atX( x ) );
+        clip( [x]( const Point& p ) { return p.x <= x + 1; }, atX( x + 1 ) );
+        clip( [y]( const Point& p ) { return p.y >= y; }, atY( y ) );
+        clip( [y]( const Point& p ) { return p.y <= y + 1; }, atY( y + 1 ) );
+
+        double fArea = 0.0;
+        for( size_t i = 0; i < v.size(); i++ )
+        {
+            const Point& a = v[i];
+            const Point& b = v[( i + 1 ) % v.size()];
+            fArea += a.x * b.y - b.x * a.y;
+        }
+        return fArea * 0.5;
+    }
+
+    // The coverage of each pixel of the glyph's box, as MakeGlyphBitmap() should draw it
+    std::vector<uint8_t> Reference( const std::vector<TestGlyph>& vGlyphs, int nGlyph, float fScale, int x0, int y0, int w, int h )
+    {
+        std::vector<std::vector<Point>> vPolygons;
+        for( auto& contour : Expand( vGlyphs, nGlyph ) )
+        {
+            std::vector<Point> polygon = Flatten( contour );
+            for( auto& p : polygon )
+            {
+                // Font units to the bitmap, y down; the font holds coordinates rounded to units
+                p.x = double( float( p.x ) * fScale ) - x0;
+                p.y = double( -float( p.y ) * fScale ) - y0;
+            }
+            vPolygons.push_back( polygon );
+        }
+
+        std::vector<uint8_t> vBitmap( size_t( w ) * size_t( h ) );
+        for( int y = 0; y < h; y++ )
+            for( int x = 0; x < w; x++ )
+            {
+                double fArea = 0.0;
+                for( auto& polygon : vPolygons )
+                    fArea += ClippedArea( polygon, x, y );
+                vBitmap[size_t( y ) * w + x] = uint8_t( std::min( 255.0, std::abs( fArea ) * 255.0 + 0.5 ) );
+            }
+        return vBitmap;
+    }
+
+    // ---------------------------------------------------------------------------------------
+    // Checks
+
+    void CheckLookups( const std::string& name, const ttf::FontInfo& font )
+    {
+        bool bMapped = true;
+        for( auto& m : vMappings )
+        {
+            // A BMP only cmap can't map the emoji
+            const int nExpected = m.nCodepoint > 0xFFFF && font.bytes.U16( font.nIndexMap ) == 4 ? 0 : m.nGlyph;
+            bMapped = bMapped && ttf::FindGlyphIndex( font, m.nCodepoint ) == nExpected;
+        }
+        Check( name + "/codepoints_map_to_their_glyphs", bMapped );
+        Check( name + "/unmapped_codepoints_are_glyph_0",
+               ttf::FindGlyphIndex( font, 'D' ) == 0 && ttf::FindGlyphIndex( font, '@' ) == 0 && ttf::FindGlyphIndex( font, 0x10FFFF ) == 0 && ttf::FindGlyphIndex( font, 0xFFFF ) == 0 );
+    }
+
+    void CheckMetrics( const std::string& name, const ttf::FontInfo& font, const std::vector<TestGlyph>& vGlyphs )
+    {
+        int nAscent, nDescent, nLineGap;
+        ttf::GetFontVMetrics( font, nAscent, nDescent, nLineGap );
+        Check( name + "/vertical_metrics", nAscent == ASCENT && nDescent == DESCENT && nLineGap == LINE_GAP );
+        Check( name + "/scales", ttf::ScaleForMappingEmToPixels( font, 20.0f ) == 20.0f / UNITS_PER_EM &&
+                                 ttf::ScaleForPixelHeight( font, 20.0f ) == 20.0f / ( ASCENT - DESCENT ) );
+
+        bool bMetrics = true;
+        for( int i = 0; i < int( vGlyphs.size() ); i++ )
+        {
+            int nAdvance, nBearing;
+            ttf::GetGlyphHMetrics( font, i, nAdvance, nBearing );
+            const int nExpected = i + 1 < int( vGlyphs.size() ) ? vGlyphs[size_t( i )].nAdvance : vGlyphs[size_t( i ) - 1].nAdvance;
+            bMetrics = bMetrics && nAdvance == nExpected && nBearing == vGlyphs[size_t( i )].nBearing;
+        }
+        Check( name + "/horizontal_metrics", bMetrics );
+    }
+
+    void CheckBitmaps( const std::string& name, const ttf::FontInfo& font, const std::vector<TestGlyph>& vGlyphs )
+    {
+        static const char* sGlyphNames[] = { "notdef", "square", "triangle", "ring", "circle", "curves", "composite" };
+        for( float fPixels : { 13.0f, 23.7f, 61.3f } )
+        {
+            const float fScale = ttf::ScaleForMappingEmToPixels( font, fPixels );
+            for( int i = 0; i < int( vGlyphs.size() ); i++ )
+            {
+                const TestGlyph& g = vGlyphs[size_t( i )];
+                int x0, y0, x1, y1;
+                ttf::GetGlyphBitmapBox( font, i, fScale, fScale, x0, y0, x1, y1 );
+                const std::string sCase = name + "/" + sGlyphNames[i] + "_" + std::to_string( int( fPixels * 10 ) );
+                if( i == 0 )
+                {
+                    Check( sCase + "_empty_box", x0 == 0 && y0 == 0 && x1 == 0 && y1 == 0 );
+                    continue;
+                }
+
+                const bool bBox = x0 == int( std::floor( g.x0 * fScale ) ) && x1 == int( std::ceil( g.x1 * fScale ) ) &&
+                                  y0 == int( std::floor( -g.y1 * fScale ) ) && y1 == int( std::ceil( -g.y0 * fScale ) );
+                Check( sCase + "_box", bBox );
+                const int w = x1 - x0, h = y1 - y0;
+                if( !bBox || w <= 0 || h <= 0 )
+                    continue;
+
+                // With a stride wider than the bitmap, which must be left alone
+                const int nStride = w + 3;
+                std::vector<uint8_t> vBitmap( size_t( nStride ) * h, 0xAB );
+                ttf::MakeGlyphBitmap( font, vBitmap.data(), w, h, nStride, fScale, fScale, i );
+                const std::vector<uint8_t> vReference = Reference( vGlyphs, i, fScale, x0, y0, w, h );
+
+                // Straight edges come out exact but for float rounding. Curves are cut into lines
+                // within a fifth of a pixel of them, which can cost an edge pixel up to that much
+                // of its coverage and a glyph a few pixels across a few percent of its ink
+                const bool bCurved = i >= 4;
+                int nMaxError = 0, nPadding = 0;
+                double fInk = 0.0, fReferenceInk = 0.0;
+                for( int y = 0; y < h; y++ )
+                {
+                    for( int x = 0; x < w; x++ )
+                    {
+                        const int n = vBitmap[size_t( y ) * nStride + x], r = vReference[size_t( y ) * w + x];
+                        nMaxError = std::max( nMaxError, std::abs( n - r ) );
+                        fInk += n;
+                        fReferenceInk += r;
+                    }
+                    for( int x = w; x < nStride; x++ )
+                        nPadding += vBitmap[size_t( y ) * nStride + x] != 0xAB;
+                }
+                const double fInkError = std::abs( fInk - fReferenceInk ) / fReferenceInk;
+                Check( sCase + "_matches_reference", nMaxError <= ( bCurved ? 56 : 2 ) && fInkError < ( bCurved ? 0.03 : 0.001 ) && nPadding == 0,
+                       "max error " + std::to_string( nMaxError ) + ", ink off by " + std::to_string( fInkError * 100.0 ) + "%, stride padding written " + std::to_string( nPadding ) );
+            }
+        }
+    }
+
+    void CheckFont( const std::string& name, const FontOptions& options )
+    {
+        const std::vector<TestGlyph> vGlyphs = TestGlyphs();
+        const std::vector<uint8_t> vFont = BuildFont( vGlyphs, options );
+
+        ttf::FontInfo font;
+        const int nOffset = ttf::GetFontOffsetForIndex( vFont.data(), vFont.size(), 0 );
+        Check( name + "/font_offset", nOffset == ( options.bCollection ? 16 : 0 ) && ttf::GetFontOffsetForIndex( vFont.data(), vFont.size(), 1 ) == -1 );
+        const bool bInit = ttf::InitFont( font, vFont.data(), vFont.size(), nOffset );
+        Check( name + "/init", bInit );
+        if( !bInit )
+            return;
+
+        CheckLookups( name, font );
+        CheckMetrics( name, font, vGlyphs );
+        CheckBitmaps( name, font, vGlyphs );
+    }
+
+    // Looks up and rasterises everything in a damaged copy of the font
+    void Exercise( const std::vector<uint8_t>& vFont, std::vector<uint8_t>& vBitmap )
+    {
+        ttf::FontInfo font;
+        const int nOffset = ttf::GetFontOffsetForIndex( vFont.data(), vFont.size(), 0 );
+        if( !ttf::InitFont( font, vFont.data(), vFont.size(), nOffset ) )
+            return;
+
+        int a, b, c, d;
+        ttf::GetFontVMetrics( font, a, b, c );
+        ttf::GetFontBoundingBox( font, a, b, c, d );
+        const float fScale = ttf::ScaleForMappingEmToPixels( font, 24.0f );
+        for( uint32_t nCodepoint : { 0x41u, 0x42u, 0x43u, 0x61u, 0x62u, 0x63u, 0x7Au, 0x1F600u } )
+            ttf::FindGlyphIndex( font, nCodepoint );
+        for( int i = 0; i < font.nGlyphs + 2; i++ )
+        {
+            ttf::GetGlyphHMetrics( font, i, a, b );
+            int x0, y0, x1, y1;
+            ttf::GetGlyphBitmapBox( font, i, fScale, fScale, x0, y0, x1, y1 );
+
+            // A damaged box can be any size - the outline is clipped to whatever is asked for
+            const int w = std::clamp( x1 - x0, 0, 64 ), h = std::clamp( y1 - y0, 0, 64 );
+            vBitmap.assign( size_t( w ) * size_t( h ) + 1, 0 );
+            ttf::MakeGlyphBitmap( font, vBitmap.data(), w, h, w, fScale, fScale, i );
+        }
+    }
+
+    void CheckDamagedFonts()
+    {
+        const std::vector<TestGlyph> vGlyphs = TestGlyphs();
+        std::vector<uint8_t> vBitmap;
+        for( bool bLongLoca : { false, true } )
+        {
+            FontOptions options;
+            options.bLongLoca = bLongLoca;
+            options.bFormat12 = bLongLoca;
+            const std::vector<uint8_t> vFont = BuildFont( vGlyphs, options );
+
+            // Every length, each copy in a buffer of exactly that size so overreads are caught
+            for( size_t n = 0; n < vFont.size(); n++ )
+                Exercise( std::vector<uint8_t>( vFont.begin(), vFont.begin() + std::ptrdiff_t( n ) ), vBitmap );
+
+            // Bytes overwritten at random, a few at a time
+            std::mt19937 rng( 1234 );
+            for( int i = 0; i < 20000; i++ )
+            {
+                std::vector<uint8_t> vDamaged = vFont;
+                for( int n = 1 + int( rng() % 4 ); n > 0; n-- )
+                    vDamaged[rng() % vDamaged.size()] = uint8_t( rng() );
+                Exercise( vDamaged, vBitmap );
+            }
+        }
+        Check( "truetype/damaged_fonts_are_read_within_their_data", true );
+    }
+}
+
+
+int main()
+{
+    CheckFont( "truetype/short_loca_format4", {} );
+    CheckFont( "truetype/long_loca_format12", { true, true, false } );
+    CheckFont( "truetype/collection", { false, false, true } );
+    CheckDamagedFonts();
+    return nFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,771 @@
+// Bakes truetype fonts into the png + .olcfont pairs olc::Font and olc::CustomFont load - the
+// same files generatefont.py and generatecustomfont.py write - many fonts and sizes per run, on
+// every core, skipping the ones whose inputs haven't changed since they were last baked.
+//
+//     font_baker [-j <threads>] [--force] <jobs.txt>...
+//
+// A jobs file lists one font per line; paths are relative to the jobs file:
+//
+//     # output         font              size  glyphs      options
+//     ui/Arial30       Arial.ttf         30    ascii
+//     ui/Arial16       Arial.ttf         16    ascii       alpha
+//     chat/NotoJP24    NotoSansJP.otf    24    chat.txt    maxpage=1024
+//
+//     output   written as <output>.png (<output>_1.png, ... for more pages) and <output>.olcfont
+//     size     the size in pixels per em, as the point size the python generators take
+//     glyphs   "ascii" for an olc::Font of the 96 printable ascii characters, otherwise a utf-8
+//              text file of the characters of an olc::CustomFont (tabs and newlines ignored).
+//              Characters the font has no glyph for are left out, so a FontChain falls back past them
+//     alpha    write 8 bit grayscale pngs holding only the coverage (see generatefont.py --alpha).
+//              A grayscale png has no room for a signature at all
+//     maxpage  largest width and height of an atlas png, 2048 by default and at most 32767
+//
+// The glyphs are packed, not laid out in the grid of the embedded format 1 rows, so every bake
+// - rgba or alpha, one page or several - only loads together with its .olcfont: ship the two side
+// by side. Without it rgba pngs carry a format 2 signature, so the fonts print that they need
+// their metrics file, while alpha pngs are read as any png without a signature.
+//
+// Next to each output a <output>.bake stamp holds a hash of everything the output was made
+// from - the font file, size, characters and options. Jobs whose stamp still matches are
+// skipped, --force bakes everything again.
+//
+// Rasterises with olcPGEX_TrueType.h, as olc::DynamicFont does.
+
+#include "../olcPGEX_TrueType.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+namespace ttf = olc::font::ttf;
+
+namespace
+{
+    // Bump when the baked output changes for the same inputs, so every stamp goes stale
+    constexpr uint32_t BAKER_VERSION = 2;
+
+    // The .olcfont layout, as olcPGEX_FontCommon.h reads it
+    constexpr uint32_t METRICS_VERSION = 1;
+    constexpr uint32_t ATLAS_COVERAGE = 1;
+
+    // The signature the generators put in the last row of the first page
+    constexpr uint32_t FORMAT_VERSION = 2;
+
+    // Cells are 2 pixels larger than the largest glyph, and glyphs start 2 pixels into their cell
+    constexpr int CELL_PADDING = 2;
+    constexpr int X_OFFSET = 2;
+
+    // Glyph positions are stored as 16 bit signed values
+    constexpr int MAX_PAGE_SIZE = 32767;
+
+
+    struct Job
+    {
+        fs::path                sOutput;
+        fs::path                sFontFile;
+        int                     nSize = 0;
+        bool                    bAscii = false;
+        fs::path                sGlyphFile;
+        bool                    bAlpha = false;
+        int                     nMaxPageSize = 2048;
+        std::string             sSource;            // jobs file and line, for messages
+    };
+
+    struct Glyph
+    {
+        uint32_t    nCodepoint = 0;
+        int         nIndex = 0;                     // in the truetype font
+        int         w = 0, h = 0;                   // size of its rectangle: from the pen or its ink, whichever is further left, to its advance or its ink
+        int         nAdvance = 0;
+        int         nShift = 0;                     // pixels its ink is moved right to keep a negative left bearing in the rectangle
+        int         page = 0, x = 0, y = 0;         // where its cell was packed
+    };
+
+    struct Page
+    {
+        int                     width = 0;
+        int                     height = 0;
+        std::vector<uint8_t>    vCoverage;
+    };
+
+
+    // ---------------------------------------------------------------------------------------
+    // Hashing, for the stamps
+
+    struct Hash
+    {
+        uint64_t n = 14695981039346656037ull;   // FNV-1a
+
+        void Add( const void* p, size_t nBytes )
+        {
+            const uint8_t* b = static_cast<const uint8_t*>( p );
+            for( size_t i = 0; i < nBytes; i++ )
+                n = ( n ^ b[i] ) * 1099511628211ull;
+        }
+
+        template<class T> void Add( const T& value ) { Add( &value, sizeof( value ) ); }
+
+        std::string Hex() const
+        {
+            char s[17];
+            snprintf( s, sizeof( s ), "%016llx", (unsigned long long)n );
+            return s;
+        }
+    };
+
+
+    // ---------------------------------------------------------------------------------------
+    // Png writing - zlib with fixed huffman codes and a greedy LZ77 match search, which brings
+    // the mostly empty atlases down to a fraction of their size without a png library
+
+    class BitWriter
+    {
+    public:
+        explicit BitWriter( std::vector<uint8_t>& vOut ) : vOut( vOut ) {}
+
+        void Bits( uint32_t nValue, int nBits )
+        {
+            nBuffer |= uint64_t( nValue ) << nCount;
+            nCount += nBits;
+            while( nCount >= 8 )
+            {
+                vOut.push_back( uint8_t( nBuffer ) );
+                nBuffer >>= 8;
+                nCount -= 8;
+            }
+        }
+
+        // Huffman codes go most significant bit first
+        void Code( uint32_t nCode, int nBits )
+        {
+            uint32_t nReversed = 0;
+            for( int i = 0; i < nBits; i++ )
+                nReversed |= ( ( nCode >> i ) & 1 ) << ( nBits - 1 - i );
+            Bits( nReversed, nBits );
+        }
+
+        void Flush()
+        {
+            if( nCount > 0 )
+                vOut.push_back( uint8_t( nBuffer ) );
+            nBuffer = 0;
+            nCount = 0;
+        }
+
+    private:
+        std::vector<uint8_t>&   vOut;
+        uint64_t                nBuffer = 0;
+        int                     nCount = 0;
+    };
+
+
+    void Literal( BitWriter& bits, uint32_t c )
+    {
+        if( c < 144 )       bits.Code( 0x30 + c, 8 );
+        else if( c < 256 )  bits.Code( 0x190 + c - 144, 9 );
+        else if( c < 280 )  bits.Code( c - 256, 7 );
+        else                bits.Code( 0xC0 + c - 280, 8 );
+    }
+
+
+    void Match( BitWriter& bits, int nLength, int nDistance )
+    {
+        static const int lengthBase[] = { 3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258 };
+        static const int lengthExtra[] = { 0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0 };
+        static const int distBase[] = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577 };
+        static const int distExtra[] = { 0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13 };
+
+        int l = 28;
+        while( lengthBase[l] > nLength ) l--;
+        Literal( bits, uint32_t( 257 + l ) );
+        bits.Bits( uint32_t( nLength - lengthBase[l] ), lengthExtra[l] );
+
+        int d = 29;
+        while( distBase[d] > nDistance ) d--;
+        bits.Code( uint32_t( d ), 5 );
+        bits.Bits( uint32_t( nDistance - distBase[d] ), distExtra[d] );
+    }
+
+
+    std::vector<uint8_t> Zlib( const std::vector<uint8_t>& vData )
+    {
+        constexpr int WINDOW = 32768;
+        constexpr int MAX_MATCH = 258;
+        constexpr int HASH_BITS = 15;
+        constexpr int MAX_CHAIN = 32;
+
+        std::vector<uint8_t> vOut = { 0x78, 0x01 };
+        BitWriter bits( vOut );
+        bits.Bits( 1, 1 );      // final block
+        bits.Bits( 1, 2 );      // fixed huffman codes
+
+        const int n = int( vData.size() );
+        std::vector<int> vHead( 1 << HASH_BITS, -1 );
+        std::vector<int> vPrev( WINDOW, -1 );
+        auto hash = [&]( int i ) { return ( ( vData[i] << 10 ) ^ ( vData[i + 1] << 5 ) ^ vData[i + 2] ) & ( ( 1 << HASH_BITS ) - 1 ); };
+        auto insert = [&]( int i )
+        {
+            if( i + 2 >= n )
+                return;
+            int h = hash( i );
+            vPrev[i & ( WINDOW - 1 )] = vHead[h];
+            vHead[h] = i;
+        };
+
+        for( int i = 0; i < n; )
+        {
+            int nBest = 0, nBestDist = 0;
+            if( i + 2 < n )
+            {
+                int nMax = std::min( MAX_MATCH, n - i );
+                int j = vHead[hash( i )];
+                for( int nChain = 0; j >= 0 && i - j <= WINDOW - 1 && nChain < MAX_CHAIN; nChain++ )
+                {
+                    int l = 0;
+                    while( l < nMax && vData[j + l] == vData[i + l] )
+                        l++;
+                    if( l > nBest )
+                    {
+                        nBest = l;
+                        nBestDist = i - j;
+                        if( l == nMax )
+                            break;
+                    }
+                    int k = vPrev[j & ( WINDOW - 1 )];
+                    if( k >= j )
+                        break;
+                    j = k;
+                }
+            }
+
+            if( nBest >= 3 )
+            {
+                Match( bits, nBest, nBestDist );
+                for( int k = 0; k < nBest; k++ )
+                    insert( i + k );
+                i += nBest;
+            }
+            else
+            {
+                Literal( bits, vData[i] );
+                insert( i );
+                i++;
+            }
+        }
+        Literal( bits, 256 );
+        bits.Flush();
+
+        uint32_t a = 1, b = 0;
+        for( uint8_t c : vData )
+        {
+            a = ( a + c ) % 65521;
+            b = ( b + a ) % 65521;
+        }
+        uint32_t nAdler = ( b << 16 ) | a;
+        for( int s = 24; s >= 0; s -= 8 )
+            vOut.push_back( uint8_t( nAdler >> s ) );
+        return vOut;
+    }
+
+
+    uint32_t Crc( const uint8_t* p, size_t n, uint32_t nCrc = 0 )
+    {
+        static const std::vector<uint32_t> vTable = []
+        {
+            std::vector<uint32_t> t( 256 );
+            for( uint32_t i = 0; i < 256; i++ )
+            {
+                uint32_t c = i;
+                for( int k = 0; k < 8; k++ )
+                    c = ( c & 1 ) ? 0xEDB88320u ^ ( c >> 1 ) : c >> 1;
+                t[i] = c;
+            }
+            return t;
+        }();
+
+        nCrc = ~nCrc;
+        for( size_t i = 0; i < n; i++ )
+            nCrc = vTable[( nCrc ^ p[i] ) & 0xFF] ^ ( nCrc >> 8 );
+        return ~nCrc;
+    }
+
+
+    // Pixels are nChannels bytes each, 4 (RGBA) or 1 (grayscale)
+    bool WritePng( const fs::path& sFile, int w, int h, int nChannels, const std::vector<uint8_t>& vPixels )
+    {
+        std::vector<uint8_t> vRaw;
+        vRaw.reserve( size_t( w * nChannels + 1 ) * h );
+        for( int y = 0; y < h; y++ )
+        {
+            vRaw.push_back( 0 );    // no filter
+            vRaw.insert( vRaw.end(), vPixels.begin() + size_t( y ) * w * nChannels, vPixels.begin() + size_t( y + 1 ) * w * nChannels );
+        }
+
+        std::vector<uint8_t> vPng = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        auto be32 = [&]( uint32_t v ) { for( int s = 24; s >= 0; s -= 8 ) vPng.push_back( uint8_t( v >> s ) ); };
+        auto chunk = [&]( const char* type, const std::vector<uint8_t>& vData )
+        {
+            be32( uint32_t( vData.size() ) );
+            size_t nStart = vPng.size();
+            vPng.insert( vPng.end(), type, type + 4 );
+            vPng.insert( vPng.end(), vData.begin(), vData.end() );
+            be32( Crc( vPng.data() + nStart, vPng.size() - nStart ) );
+        };
+
+        std::vector<uint8_t> vHeader;
+        for( uint32_t v : { uint32_t( w ), uint32_t( h ) } )
+            for( int s = 24; s >= 0; s -= 8 )
+                vHeader.push_back( uint8_t( v >> s ) );
+        vHeader.insert( vHeader.end(), { 8, uint8_t( nChannels == 4 ? 6 : 0 ), 0, 0, 0 } );
+        chunk( "IHDR", vHeader );
+        chunk( "IDAT", Zlib( vRaw ) );
+        chunk( "IEND", {} );
+
+        std::ofstream file( sFile, std::ios::binary );
+        file.write( reinterpret_cast<const char*>( vPng.data() ), std::streamsize( vPng.size() ) );
+        return bool( file );
+    }
+
+
+    // ---------------------------------------------------------------------------------------
+    // Reading the inputs
+
+    bool ReadFile( const fs::path& sFile, std::vector<uint8_t>& vData )
+    {
+        std::ifstream file( sFile, std::ios::binary );
+        if( !file )
+            return false;
+        vData.assign( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+        return true;
+    }
+
+
+    // The characters of a glyph set file, sorted and unique, as generatecustomfont.py reads them
+    std::vector<uint32_t> ReadGlyphSet( const std::vector<uint8_t>& vText )
+    {
+        std::set<uint32_t> set;
+        for( size_t i = 0; i < vText.size(); )
+        {
+            uint8_t b = vText[i];
+            int nMore = b < 0x80 ? 0 : b < 0xE0 ? 1 : b < 0xF0 ? 2 : 3;
+            uint32_t c = nMore == 0 ? b : nMore == 1 ? b & 0x1F : nMore == 2 ? b & 0x0F : b & 0x07;
+            i++;
+            for( int k = 0; k < nMore && i < vText.size(); k++, i++ )
+                c = ( c << 6 ) | ( vText[i] & 0x3F );
+            if( c == 0xFEFF || c == '\t' || c == '\r' || c == '\n' )
+                continue;
+            set.insert( c );
+        }
+        return { set.begin(), set.end() };
+    }
+
+
+    bool ParseJobs( const fs::path& sJobsFile, std::vector<Job>& vJobs )
+    {
+        std::ifstream file( sJobsFile );
+        if( !file )
+        {
+            fprintf( stderr, "Unable to open %s\n", sJobsFile.string().c_str() );
+            return false;
+        }
+
+        const fs::path sDir = sJobsFile.parent_path();
+        std::string sLine;
+        for( int nLine = 1; std::getline( file, sLine ); nLine++ )
+        {
+            sLine = sLine.substr( 0, sLine.find( '#' ) );
+            std::istringstream words( sLine );
+            std::string sOutput, sFont, sSize, sGlyphs;
+            if( !( words >> sOutput ) )
+                continue;
+
+            Job job;
+            job.sSource = sJobsFile.string() + ":" + std::to_string( nLine );
+            if( !( words >> sFont >> sSize >> sGlyphs ) || ( job.nSize = atoi( sSize.c_str() ) ) <= 0 )
+            {
+                fprintf( stderr, "%s: expected <output> <font> <size> <glyphs> [options]\n", job.sSource.c_str() );
+                return false;
+            }
+
+            job.sOutput = sDir / sOutput;
+            job.sFontFile = sDir / sFont;
+            job.bAscii = sGlyphs == "ascii";
+            if( !job.bAscii )
+                job.sGlyphFile = sDir / sGlyphs;
+
+            for( std::string sOption; words >> sOption; )
+            {
+                if( sOption == "alpha" )
+                    job.bAlpha = true;
+                else if( sOption.rfind( "maxpage=", 0 ) == 0 && atoi( sOption.c_str() + 8 ) > 1 && atoi( sOption.c_str() + 8 ) <= MAX_PAGE_SIZE )
+                    job.nMaxPageSize = atoi( sOption.c_str() + 8 );
+                else
+                {
+                    fprintf( stderr, "%s: unknown option %s\n", job.sSource.c_str(), sOption.c_str() );
+                    return false;
+                }
+            }
+            vJobs.push_back( job );
+        }
+        return true;
+    }
+
+
+    // ---------------------------------------------------------------------------------------
+    // Baking
+
+    // Shelf packs the cells left to right in rows of pages, as _pack_glyphs() in the generators.
+    // The last pixel row of each page is left free for the signature
+    bool PackGlyphs( std::vector<Glyph>& vGlyphs, int nCellHeight, int nMaxPageSize, std::vector<Page>& vPages )
+    {
+        int nWidest = 0;
+        long long nArea = 0;
+        for( auto& g : vGlyphs )
+        {
+            nWidest = std::max( nWidest, g.w + X_OFFSET );
+            nArea += (long long)( g.w + X_OFFSET ) * nCellHeight;
+        }
+        const int nRowsPerPage = ( nMaxPageSize - 1 ) / nCellHeight;
+        if( nWidest > nMaxPageSize || nRowsPerPage < 1 )
+            return false;
+
+        // Aim for roughly square pages
+        const int nPageWidth = std::min( nMaxPageSize, std::max( nWidest, int( std::ceil( std::sqrt( double( nArea ) ) ) ) ) );
+
+        int page = 0, row = 0, x = 0, nUsedWidth = 0;
+        for( auto& g : vGlyphs )
+        {
+            const int w = g.w + X_OFFSET;
+            if( x + w > nPageWidth )
+            {
+                row++;
+                x = 0;
+                if( row == nRowsPerPage )
+                {
+                    vPages.push_back( { nUsedWidth, nRowsPerPage * nCellHeight + 1, {} } );
+                    page++;
+                    row = 0;
+                    nUsedWidth = 0;
+                }
+            }
+            g.page = page;
+            g.x = x;
+            g.y = row * nCellHeight;
+            x += w;
+            nUsedWidth = std::max( nUsedWidth, x );
+        }
+        vPages.push_back( { nUsedWidth, ( row + 1 ) * nCellHeight + 1, {} } );
+        return true;
+    }
+
+
+    bool WriteMetrics( const fs::path& sFile, int nCharWidth, int nCharHeight, const std::vector<Glyph>& vGlyphs, uint32_t nPages, uint32_t nFlags )
+    {
+        std::vector<uint8_t> vData;
+        auto u32 = [&]( uint32_t v ) { for( int s = 0; s < 32; s += 8 ) vData.push_back( uint8_t( v >> s ) ); };
+        auto u16 = [&]( uint32_t v ) { vData.push_back( uint8_t( v ) ); vData.push_back( uint8_t( v >> 8 ) ); };
+
+        vData.insert( vData.end(), { 'O', 'L', 'C', 'F' } );
+        u32( METRICS_VERSION ); u32( uint32_t( vGlyphs.size() ) ); u32( uint32_t( nCharWidth ) ); u32( uint32_t( nCharHeight ) );
+        u32( nPages ); u32( nFlags ); u32( 0 );
+
+        // Glyphs are already in codepoint order
+        for( auto& g : vGlyphs )
+        {
+            u32( g.nCodepoint );
+            u16( uint32_t( g.x + X_OFFSET ) ); u16( uint32_t( g.y ) ); u16( uint32_t( g.w ) ); u16( uint32_t( nCharHeight - 1 ) );
+            u16( uint32_t( g.nAdvance ) ); u16( uint32_t( g.page ) );
+        }
+
+        std::ofstream file( sFile, std::ios::binary );
+        file.write( reinterpret_cast<const char*>( vData.data() ), std::streamsize( vData.size() ) );
+        return bool( file );
+    }
+
+
+    fs::path OutputFile( const Job& job, const char* sSuffix )
+    {
+        fs::path sFile = job.sOutput;
+        sFile += sSuffix;
+        return sFile;
+    }
+
+
+    fs::path PageFile( const Job& job, size_t nPage )
+    {
+        return OutputFile( job, nPage == 0 ? ".png" : ( "_" + std::to_string( nPage ) + ".png" ).c_str() );
+    }
+
+
+    enum class Outcome { Baked, UpToDate, Failed };
+
+    Outcome Bake( const Job& job, bool bForce, std::string& sMessage )
+    {
+        std::vector<uint8_t> vFontData, vGlyphText;
+        if( !ReadFile( job.sFontFile, vFontData ) )
+        {
+            sMessage = "unable to read " + job.sFontFile.string();
+            return Outcome::Failed;
+        }
+
+        std::vector<uint32_t> vCodepoints;
+        if( job.bAscii )
+        {
+            for( uint32_t c = 32; c < 128; c++ )
+                vCodepoints.push_back( c );
+        }
+        else
+        {
+            if( !ReadFile( job.sGlyphFile, vGlyphText ) )
+            {
+                sMessage = "unable to read " + job.sGlyphFile.string();
+                return Outcome::Failed;
+            }
+            vCodepoints = ReadGlyphSet( vGlyphText );
+        }
+
+        // Skip the job when nothing it is made from has changed
+        Hash hash;
+        hash.Add( BAKER_VERSION );
+        hash.Add( vFontData.data(), vFontData.size() );
+        hash.Add( job.nSize );
+        hash.Add( job.bAscii );
+        hash.Add( job.bAlpha );
+        hash.Add( job.nMaxPageSize );
+        hash.Add( vCodepoints.data(), vCodepoints.size() * sizeof( uint32_t ) );
+        const std::string sStamp = "olc font baker " + hash.Hex();
+        const fs::path sStampFile = OutputFile( job, ".bake" );
+        if( !bForce && fs::exists( PageFile( job, 0 ) ) && fs::exists( OutputFile( job, ".olcfont" ) ) )
+        {
+            std::ifstream stamp( sStampFile );
+            std::string sOld;
+            if( std::getline( stamp, sOld ) && sOld == sStamp )
+                return Outcome::UpToDate;
+        }
+
+        ttf::FontInfo font;
+        if( !ttf::InitFont( font, vFontData.data(), vFontData.size(), ttf::GetFontOffsetForIndex( vFontData.data(), vFontData.size(), 0 ) ) )
+        {
+            sMessage = job.sFontFile.string() + " is not a truetype font";
+            return Outcome::Failed;
+        }
+
+        // Pixels per em, as the size Pillow's ImageFont.truetype() takes
+        const float fScale = ttf::ScaleForMappingEmToPixels( font, float( job.nSize ) );
+        int nAscent, nDescent, nLineGap;
+        ttf::GetFontVMetrics( font, nAscent, nDescent, nLineGap );
+        const int nBaseline = int( std::ceil( float( nAscent ) * fScale ) );
+
+        // Size each glyph's rectangle to hold both its advance and its ink. The metrics have no
+        // room for a bearing, so ink left of the pen is moved right into the rectangle rather than cut
+        std::vector<Glyph> vGlyphs;
+        size_t nMissing = 0;
+        int nCharWidth = 0, nCharHeight = 0;
+        for( uint32_t c : vCodepoints )
+        {
+            Glyph g;
+            g.nCodepoint = c;
+            g.nIndex = ttf::FindGlyphIndex( font, c );
+            if( g.nIndex == 0 && !job.bAscii && c != ' ' )
+            {
+                // A custom font simply doesn't have it, olc::Font needs all 96
+                nMissing++;
+                continue;
+            }
+
+            int nAdvance, nBearing, x0, y0, x1, y1;
+            ttf::GetGlyphHMetrics( font, g.nIndex, nAdvance, nBearing );
+            ttf::GetGlyphBitmapBox( font, g.nIndex, fScale, fScale, x0, y0, x1, y1 );
+            g.nAdvance = int( std::lround( float( nAdvance ) * fScale ) );
+            g.nShift = x1 > x0 ? std::max( 0, -x0 ) : 0;
+            g.w = std::max( g.nAdvance, x1 > x0 ? x1 : 0 ) + g.nShift;
+            g.h = nBaseline + std::max( y1, int( std::ceil( -float( nDescent ) * fScale ) ) );
+            nCharWidth = std::max( nCharWidth, g.w );
+            nCharHeight = std::max( nCharHeight, g.h );
+            vGlyphs.push_back( g );
+        }
+        if( vGlyphs.empty() )
+        {
+            sMessage = "the font has none of the characters asked for";
+            return Outcome::Failed;
+        }
+        nCharWidth += CELL_PADDING;
+        nCharHeight += CELL_PADDING;
+
+        std::vector<Page> vPages;
+        if( !PackGlyphs( vGlyphs, nCharHeight, job.nMaxPageSize, vPages ) )
+        {
+            sMessage = "a glyph does not fit on a " + std::to_string( job.nMaxPageSize ) + " pixel page";
+            return Outcome::Failed;
+        }
+        if( job.bAscii && vPages.size() > 1 )
+        {
+            sMessage = "the glyphs do not fit on a single page, try a larger maxpage";
+            return Outcome::Failed;
+        }
+
+        // Rasterise each glyph straight into its rectangle. The X_OFFSET pixels between rectangles
+        // stay empty, so a glyph drawn with bilinear filtering doesn't pick up its neighbour
+        for( auto& page : vPages )
+            page.vCoverage.assign( size_t( page.width ) * page.height, 0 );
+        std::vector<uint8_t> vBitmap;
+        for( auto& g : vGlyphs )
+        {
+            int x0, y0, x1, y1;
+            ttf::GetGlyphBitmapBox( font, g.nIndex, fScale, fScale, x0, y0, x1, y1 );
+            const int bw = x1 - x0, bh = y1 - y0;
+            if( bw <= 0 || bh <= 0 )
+                continue;
+            vBitmap.assign( size_t( bw ) * bh, 0 );
+            ttf::MakeGlyphBitmap( font, vBitmap.data(), bw, bh, bw, fScale, fScale, g.nIndex );
+
+            Page& page = vPages[g.page];
+            const int left = g.x + X_OFFSET, right = left + g.w, bottom = g.y + nCharHeight;
+            const int ox = left + g.nShift + x0, oy = g.y + nBaseline + y0;
+            for( int y = std::max( 0, g.y - oy ); y < bh && oy + y < bottom; y++ )
+                for( int x = std::max( 0, left - ox ); x < bw && ox + x < right; x++ )
+                    page.vCoverage[size_t( oy + y ) * page.width + ox + x] = std::max( page.vCoverage[size_t( oy + y ) * page.width + ox + x], vBitmap[size_t( y ) * bw + x] );
+        }
+
+        fs::create_directories( fs::absolute( job.sOutput ).parent_path() );
+        for( size_t p = 0; p < vPages.size(); p++ )
+        {
+            const Page& page = vPages[p];
+            std::vector<uint8_t> vPixels;
+            if( job.bAlpha )
+                vPixels = page.vCoverage;
+            else
+            {
+                // White glyphs, the coverage in the alpha
+                vPixels.resize( page.vCoverage.size() * 4 );
+                for( size_t i = 0; i < page.vCoverage.size(); i++ )
+                {
+                    uint8_t a = page.vCoverage[i];
+                    vPixels[i * 4 + 0] = a ? 255 : 0;
+                    vPixels[i * 4 + 1] = a ? 255 : 0;
+                    vPixels[i * 4 + 2] = a ? 255 : 0;
+                    vPixels[i * 4 + 3] = a;
+                }
+
+                // <"FONT"> or <"CFON"> <format_version> in the last row of the first page. A
+                // grayscale png has no room for it
+                if( p == 0 )
+                {
+                    uint8_t* pRow = &vPixels[size_t( page.height - 1 ) * page.width * 4];
+                    memcpy( pRow, job.bAscii ? "FONT" : "CFON", 4 );
+                    for( int s = 0; s < 4; s++ )
+                        pRow[4 + s] = uint8_t( FORMAT_VERSION >> ( s * 8 ) );
+                }
+            }
+
+            if( !WritePng( PageFile( job, p ), page.width, page.height, job.bAlpha ? 1 : 4, vPixels ) )
+            {
+                sMessage = "unable to write " + PageFile( job, p ).string();
+                return Outcome::Failed;
+            }
+        }
+
+        // Pages left over from an earlier, larger bake
+        for( size_t p = vPages.size(); fs::exists( PageFile( job, p ) ); p++ )
+            fs::remove( PageFile( job, p ) );
+
+        // The pngs are unusable without it, so a job that can't write it fails
+        if( !WriteMetrics( OutputFile( job, ".olcfont" ), nCharWidth, nCharHeight, vGlyphs, uint32_t( vPages.size() ), job.bAlpha ? ATLAS_COVERAGE : 0 ) )
+        {
+            sMessage = "unable to write " + OutputFile( job, ".olcfont" ).string();
+            return Outcome::Failed;
+        }
+        std::ofstream( sStampFile ) << sStamp << "\n";
+
+        sMessage = std::to_string( vGlyphs.size() ) + " glyphs on " + std::to_string( vPages.size() ) + ( vPages.size() == 1 ? " page" : " pages" );
+        if( nMissing > 0 )
+            sMessage += ", " + std::to_string( nMissing ) + " characters not in the font";
+        return Outcome::Baked;
+    }
+
+
+    void Usage()
+    {
+        printf( "\nUsage: font_baker [-j <threads>] [--force] <jobs.txt>...\n\n" );
+        printf( "Each line of a jobs file bakes one font:\n\n\t<output> <font.ttf> <size> <ascii | glyphs.txt> [alpha] [maxpage=<pixels>]\n\n" );
+        printf( "-j        threads to bake on, every core by default\n" );
+        printf( "--force   bake every job, even those whose inputs haven't changed\n\n" );
+    }
+}
+
+
+int main( int argc, char* argv[] )
+{
+    unsigned nThreads = std::max( 1u, std::thread::hardware_concurrency() );
+    bool bForce = false;
+    std::vector<Job> vJobs;
+    for( int i = 1; i < argc; i++ )
+    {
+        std::string sArg = argv[i];
+        if( sArg == "-j" && i + 1 < argc )
+            nThreads = unsigned( std::max( 1, atoi( argv[++i] ) ) );
+        else if( sArg == "--force" )
+            bForce = true;
+        else if( sArg.empty() || sArg[0] == '-' )
+        {
+            Usage();
+            return 1;
+        }
+        else if( !ParseJobs( sArg, vJobs ) )
+            return 1;
+    }
+    if( vJobs.empty() )
+    {
+        Usage();
+        return 1;
+    }
+
+    // Jobs are handed out one at a time, so a thread done with a small font takes the next
+    // instead of waiting on a share of the list
+    std::atomic<size_t> nNext{ 0 };
+    std::atomic<size_t> nBaked{ 0 }, nUpToDate{ 0 }, nFailed{ 0 };
+    std::mutex output;
+    auto worker = [&]
+    {
+        for( size_t i; ( i = nNext++ ) < vJobs.size(); )
+        {
+            std::string sMessage;
+            Outcome outcome = Bake( vJobs[i], bForce, sMessage );
+            std::lock_guard<std::mutex> lock( output );
+            if( outcome == Outcome::Baked )
+            {
+                nBaked++;
+                printf( "Baked %s: %s\n", vJobs[i].sOutput.string().c_str(), sMessage.c_str() );
+            }
+            else if( outcome == Outcome::UpToDate )
+                nUpToDate++;
+            else
+            {
+                nFailed++;
+                fprintf( stderr, "%s: %s\n", vJobs[i].sSource.c_str(), sMessage.c_str() );
+            }
+        }
+    };
+
+    std::vector<std::thread> vThreads;
+    for( unsigned t = 1; t < std::min<size_t>( nThreads, vJobs.size() ); t++ )
+        vThreads.emplace_back( worker );
+    worker();
+    for( auto& thread : vThreads )
+        thread.join();
+
+    printf( "%zu baked, %zu up to date, %zu failed\n", nBaked.load(), nUpToDate.load(), nFailed.load() );
+    return nFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,80 @@
+"""
+    Shared by generatefont.py and generatecustomfont.py: the pixels embedded in the pngs, the .olcfont
+    metrics file, and the packing of glyphs onto atlas pages. Keep it next to the two scripts.
+"""
+import math
+import struct
+
+
+# Metrics flag: the atlas pngs are 8 bit grayscale holding only the coverage of each pixel
+ATLAS_COVERAGE = 1
+
+# Metrics flag: the glyphs sit in the fixed size cells of the layout with embedded metrics
+ATLAS_GRID = 2
+
+# Glyph positions and sizes are stored as 16 bit signed values, so no page may be larger
+MAX_PAGE_SIZE = 32767
+
+
+def make_pixel( val ):
+    """
+        Construct a pixel tuple of (R,G,B,A) from the unsigned integer val.
+        Used to explicitly embed font metric data into the png
+    """
+    return ( (val & 0x000000ff, (val & 0x0000ff00) >> 8, (val & 0x00ff0000) >> 16, (val & 0xff000000) >> 24) )
+
+
+def check_page_size( maxPageSize ):
+    """
+        Raises ValueError unless maxPageSize can be stored in the metrics file
+    """
+    if type(maxPageSize) != int or maxPageSize < 2 or maxPageSize > MAX_PAGE_SIZE:
+        raise ValueError( f"The page size must be between 2 and {MAX_PAGE_SIZE} pixels, not {maxPageSize}" )
+
+
+def write_metrics( filename, charwidth, charheight, glyphs, pages=1, flags=0 ):
+    """
+        Write the .olcfont metrics file that the C++ loaders read in preference to the pixel data embedded in the png.
+        glyphs is a list of (codepoint, x, y, w, h, advance, page) tuples.
+        Layout (little endian): "OLCF", version, glyph count, char width, char height, page count, flags, a reserved word,
+        then one (codepoint u32, x i16, y i16, w i16, h i16, advance i16, page u16) record per glyph sorted by codepoint.
+    """
+    format_version = 1
+    with open( filename, "wb" ) as f:
+        f.write( struct.pack( "<4sIIiiIII", b"OLCF", format_version, len(glyphs), charwidth, charheight, pages, flags, 0 ) )
+        for g in sorted( glyphs ):
+            f.write( struct.pack( "<IhhhhhH", *g ) )
+
+
+def pack_glyphs( cellwidths, cellheight, maxPageSize ):
+    """
+        Shelf pack glyph cells onto as few atlas pages as possible. Every cell is one line high, so the
+        cells are simply placed left to right in rows - unlike a fixed grid each cell is only as wide as its glyph.
+        The last pixel row of each page is left free for the embedded font signature.
+
+        Returns a (page, x, y) tuple for each cell and a (width, height) tuple for each page.
+    """
+    check_page_size( maxPageSize )
+    widest = max( cellwidths )
+    rowsPerPage = (maxPageSize - 1) // cellheight
+    if widest > maxPageSize or rowsPerPage < 1:
+        raise ValueError( f"A glyph does not fit on a {maxPageSize}x{maxPageSize} page" )
+
+    # Aim for roughly square pages
+    area = sum( cellwidths ) * cellheight
+    pageWidth = min( maxPageSize, max( widest, math.ceil( math.sqrt( area ) ) ) )
+
+    positions = []
+    pages = []
+    page, row, x, usedWidth = 0, 0, 0, 0
+    for w in cellwidths:
+        if x + w > pageWidth:
+            row, x = row + 1, 0
+            if row == rowsPerPage:
+                pages.append( (usedWidth, rowsPerPage * cellheight + 1) )
+                page, row, usedWidth = page + 1, 0, 0
+        positions.append( (page, x, row * cellheight) )
+        x += w
+        usedWidth = max( usedWidth, x )
+    pages.append( (usedWidth, (row + 1) * cellheight + 1) )
+    return positions, pages
@@ -7,18 +7,10 @@ try:
 except:
     print( "\nRequires the Pillow python module to produce font images\nPlease 'pip install pillow'" )
     exit(1)
+from fontcommon import ATLAS_COVERAGE, ATLAS_GRID, check_page_size, make_pixel, pack_glyphs, write_metrics
 
 
-def _make_pixel( val ):
-    """
-        Construct a pixel tuple of (R,G,B,A) from the unsigned integer val.
-        Used to explicitly embed font metric data into the png
-    """
-    return ( (val & 0x000000ff, (val & 0x0000ff00) >> 8, (val & 0x00ff0000) >> 16, (val & 0xff000000) >> 24) )
-
-
-
-def GenerateFont( fontName, pointSize, glyphset, fillColour=(255,255,255,255), outlineWidth=0, outlineColour=(255,255,255,255) ):
+def GenerateFont( fontName, pointSize, glyphset, fillColour=(255,255,255,255), outlineWidth=0, outlineColour=(255,255,255,255), maxPageSize=2048, alpha=False ):
     """
         fontName –  A filename or file-like object containing a TrueType font. 
                     If the file is not found in this filename, the loader may also search in other directories, 
@@ -34,12 +26,21 @@ def GenerateFont( fontName, pointSize, glyphset, fillColour=(255,255,255,255), o
 
         outlineColour - The colour used to render the character outline if its outlineWidth is not 0
 
+        alpha - Write 8 bit grayscale pngs holding only the coverage of each pixel, a quarter of the size once loaded.
+                The text is coloured when drawn, so only the alpha of fillColour and outlineColour is used.
+                The glyphs are packed tightly and the fonts can only be loaded together with their metrics file.
+
+        maxPageSize - The largest width and height of an atlas png, at most 32767. Glyphs that don't fit on one page are packed
+                      tightly and spread over several.
+
         example :-  GenerateFont( "Arial.ttf", 30 )
 
                     Will attempt to create a font png with 30 point characters using Arial.ttf on the local machine.
-                    The result will be a png file called "Arial.png" if successful. The resulting png has embedded 
-                    font metric information on the last row of pixels and is used by the olcPGEX_Font class to configure the
-                    font for rendering with both fixed size and proportional spacing.
+                    The result will be a png file called "Arial.png" if successful, with the font metrics embedded in
+                    rows of pixels below the glyphs (or "Arial.png", "Arial_1.png", "Arial_2.png"... without them when
+                    the glyphs need more than one page), and "Arial.olcfont" holding the font metrics, which the
+                    olcPGEX_CustomFont class reads in preference to configure the font for rendering with both fixed
+                    size and proportional spacing.
     """
     assert( type(fontName) == str )
     assert( type(pointSize) == int and pointSize > 0 )
@@ -54,13 +55,14 @@ def GenerateFont( fontName, pointSize, glyphset, fillColour=(255,255,255,255), o
     basefilename = os.path.basename( fontName )
     rootfilename = os.path.splitext(basefilename)[0]
     pngfilename = f'{rootfilename}.png'
+    metricsfilename = f'{rootfilename}.olcfont'
 
     charwidth = 0
     charheight = 0
     
     # Build a list of character sizes for the loaded font and keep track of the max size in order to 
     # construct the output png image
-    chars = list(glyphset)
+    chars = sorted(glyphset)
     charSizes = []
     for c in chars:
         w,h = font.getsize( c )
@@ -77,58 +79,95 @@ def GenerateFont( fontName, pointSize, glyphset, fillColour=(255,255,255,255), o
     # All glyphs will be offset by 'xoffset' when being pasted onto the png image
     xoffset = 2
 
-    # Construct the font png image - using an extra row which will contain the embedded font information
+    try:
+        check_page_size( maxPageSize )
+    except ValueError as e:
+        print( f"\n{e}\n" )
+        return
+
+    # Lay the glyphs out in a sqrt(n) grid with the metrics in extra rows of pixels below, which loads
+    # without the metrics file, whenever that fits on a page: <"CFON"> <format_version> <glyph count>
+    # <xOffset> <charwidth> <charheight> then the width and unicode value of each glyph
     charsPerRow = math.ceil( math.sqrt( len(chars) ) )
-    
-    nDataPixels = len(chars) * 2 + 5 # TODO: use this to ensure we have enough pixel rows to accommodate the data
+    nDataPixels = len(chars) * 2 + 6
     imageWidth = charsPerRow * charwidth
     nDataRows = math.ceil( nDataPixels / imageWidth )
     imageHeight = (charsPerRow * charheight) + nDataRows
-    fontimage = Image.new("RGBA", (imageWidth, imageHeight), (0,0,0,0) )
 
-    # Render each character into the png image
-    dc = ImageDraw.Draw( fontimage )
+    # Otherwise, and always for grayscale pngs which have no room for the embedded metrics, the glyph
+    # cells - each only as wide as its glyph plus the offset - are packed tightly onto one or more pages
+    grid = not alpha and imageWidth <= maxPageSize and imageHeight <= maxPageSize
+    if grid:
+        positions = [ (0, (i % charsPerRow) * charwidth, (i // charsPerRow) * charheight) for i in range(len(chars)) ]
+        pages = [ (imageWidth, imageHeight) ]
+    else:
+        try:
+            positions, pages = pack_glyphs( [ w + xoffset for w,h in charSizes ], charheight, maxPageSize )
+        except ValueError as e:
+            print( f"\n{e}\n" )
+            return
+
+    if alpha:
+        fontimages = [ Image.new("L", size, 0 ) for size in pages ]
+        fillColour, outlineColour = fillColour[3], outlineColour[3]
+    else:
+        fontimages = [ Image.new("RGBA", size, (0,0,0,0) ) for size in pages ]
+
+    # Render each character into its page
+    for i,c in enumerate(chars):
+        page, x, y = positions[i]
+        dc = ImageDraw.Draw( fontimages[page] )
+        dc.text( (x + xoffset + outlineWidth, y + outlineWidth), c, font=font, fill=fillColour, stroke_width=outlineWidth, stroke_fill=outlineColour )
+
+    # Write the font information into the data rows. Packed glyph rectangles live in the metrics file
+    # only, the last row of the first page then just carries the <"CFON"> <2> signature so the loaders
+    # can tell it from the grid. A grayscale png has no room for either
+    if grid:
+        datarow = imageHeight - nDataRows
+        data = [ ( ord('C'), ord('F'), ord('O'), ord('N') ), make_pixel(1), make_pixel(len(chars)), make_pixel(xoffset), make_pixel(charwidth), make_pixel(charheight) ]
+        for i,c in enumerate(charSizes):
+            data += [ make_pixel(c[0]), make_pixel( ord(chars[i]) ) ]
+        for offset,pixel in enumerate(data):
+            fontimages[0].putpixel( (offset % imageWidth, datarow + (offset // imageWidth)), pixel )
+    elif not alpha:
+        lastrow = fontimages[0].height - 1
+        fontimages[0].putpixel( (0, lastrow), ( ord('C'), ord('F'), ord('O'), ord('N') )  )
+        fontimages[0].putpixel( (1, lastrow), make_pixel(2) )
+
+    # Write the font png files - the first page is <font>.png, any others <font>_1.png, <font>_2.png ...
+    for page,image in enumerate(fontimages):
+        filename = pngfilename if page == 0 else f'{rootfilename}_{page}.png'
+        image.save( filename )
+        print( f"Created font {filename}" )
+
+    # And the glyph metrics
+    glyphs = []
     for i,c in enumerate(chars):
-        dc.text( ((i % charsPerRow) * charwidth + xoffset + outlineWidth, (i // charsPerRow) * charheight + outlineWidth), c, font=font, fill=fillColour, stroke_width=outlineWidth, stroke_fill=outlineColour )
-
-    # Write the font information into the last row of pixels
-    # <"CFON"> <format_version> <xOffset> followed by 96 character widths
-    datarow = fontimage.height - nDataRows
-    format_version = 1
-    fontimage.putpixel( (0, datarow), ( ord('C'), ord('F'), ord('O'), ord('N') )  )
-    fontimage.putpixel( (1, datarow), _make_pixel(format_version) )
-    fontimage.putpixel( (2, datarow), _make_pixel(len(chars)))
-    fontimage.putpixel( (3, datarow), _make_pixel(xoffset) )
-    fontimage.putpixel( (4, datarow), _make_pixel(charwidth) )
-    fontimage.putpixel( (5, datarow), _make_pixel(charheight) )
-    offset = 6
-    for i,c in enumerate(charSizes):
-        # Write the character width
-        fontimage.putpixel( (offset % imageWidth, datarow + (offset // imageWidth)), _make_pixel(c[0]) )
-        offset += 1
-        # Write the unicode value
-        fontimage.putpixel( (offset % imageWidth, datarow + (offset // imageWidth)), _make_pixel( ord(chars[i]) ) )
-        offset += 1
-
-    # Write the font png file with the font information embedded
-    fontimage.save( pngfilename )
-    print( f"Created font {pngfilename}" )
+        page, x, y = positions[i]
+        glyphs.append( (ord(c), x + xoffset, y, charSizes[i][0], charheight - 1, charSizes[i][0], page) )
+    write_metrics( metricsfilename, charwidth, charheight, glyphs, len(pages), (ATLAS_COVERAGE if alpha else 0) | (ATLAS_GRID if grid else 0) )
+    print( f"Created font metrics {metricsfilename}" )
 
 
 
 def _fail_with_usage():
-    print( f"\nUsage: python generatecustomfont.py <fontName> <pointSize> <glyphset_filename>\n\n\tExample:  python generatecustomfont.py coolfont.ttf 30 glyphs.txt\n" )
+    print( f"\nUsage: python generatecustomfont.py [--alpha] <fontName> <pointSize> <glyphset_filename> [maxPageSize]\n\n\tExample:  python generatecustomfont.py coolfont.ttf 30 glyphs.txt\n" )
     print( "<glyphset_filename> should be the name of a text file which contains every character you wish you include in your font\n" )
+    print( "[maxPageSize] is the largest width and height of an atlas png (default 2048, at most 32767)\n" )
+    print( "--alpha writes 8 bit grayscale pngs holding only the coverage of each pixel\n" )
     exit(1)
 
 
 if __name__ == "__main__":
-    if len(sys.argv) < 4:
+    args = [ a for a in sys.argv[1:] if a != "--alpha" ]
+    alpha = len(args) < len(sys.argv) - 1
+    if len(args) < 3:
         _fail_with_usage()
 
-    fontName, pointSize, glyphsetfilename = sys.argv[1:4]
+    fontName, pointSize, glyphsetfilename = args[0:3]
     try:
         pointSize = int(pointSize)
+        maxPageSize = int(args[3]) if len(args) > 3 else 2048
     except:
         _fail_with_usage()
 
@@ -142,6 +181,6 @@ if __name__ == "__main__":
     else:
         print( f"Unable to load the glyph set file {glyphsetfilename}\n" )
 
-    GenerateFont( fontName, pointSize, glyphset )
+    GenerateFont( fontName, pointSize, glyphset, maxPageSize=maxPageSize, alpha=alpha )
 
 
@@ -5,17 +5,10 @@ try:
 except:
     print( "\nRequires the Pillow python module to produce font images\nPlease 'pip install pillow'" )
     exit(1)
+from fontcommon import ATLAS_COVERAGE, ATLAS_GRID, check_page_size, make_pixel, pack_glyphs, write_metrics
 
 
-def _make_pixel( val ):
-    """
-        Construct a pixel tuple of (R,G,B,A) from the unsigned integer val.
-        Used to explicitly embed font metric data into the png
-    """
-    return ( (val & 0x000000ff, (val & 0x0000ff00) >> 8, (val & 0x00ff0000) >> 16, (val & 0xff000000) >> 24) )
-
-
-def GenerateFont( fontName, pointSize, fillColour=(255,255,255,255), outlineWidth=0, outlineColour=(255,255,255,255) ):
+def GenerateFont( fontName, pointSize, fillColour=(255,255,255,255), outlineWidth=0, outlineColour=(255,255,255,255), maxPageSize=2048, alpha=False ):
     """
         fontName –  A filename or file-like object containing a TrueType font. 
                     If the file is not found in this filename, the loader may also search in other directories, 
@@ -29,12 +22,18 @@ def GenerateFont( fontName, pointSize, fillColour=(255,255,255,255), outlineWidt
 
         outlineColour - The colour used to render the character outline if its outlineWidth is not 0
 
+        alpha - Write 8 bit grayscale pngs holding only the coverage of each pixel, a quarter of the size once loaded.
+                The text is coloured when drawn, so only the alpha of fillColour and outlineColour is used.
+                The glyphs are packed tightly and the fonts can only be loaded together with their metrics file.
+
+        maxPageSize - The largest width and height of an atlas png, at most 32767. All 96 glyphs have to fit on one page.
+
         example :-  GenerateFont( "Arial.ttf", 30 )
 
                     Will attempt to create a font png with 30 point characters using Arial.ttf on the local machine.
-                    The result will be a png file called "Arial.png" if successful. The resulting png has embedded 
-                    font metric information on the last row of pixels and is used by the olcPGEX_Font class to configure the
-                    font for rendering with both fixed size and proportional spacing.
+                    The result will be a png file called "Arial.png" if successful, with the font metrics embedded in
+                    its last row of pixels, and "Arial.olcfont" holding the same metrics, which the olcPGEX_Font class
+                    reads in preference to configure the font for rendering with both fixed size and proportional spacing.
     """
     assert( type(fontName) == str )
     assert( type(pointSize) == int and pointSize > 0 )
@@ -48,6 +47,7 @@ def GenerateFont( fontName, pointSize, fillColour=(255,255,255,255), outlineWidt
     basefilename = os.path.basename( fontName )
     rootfilename = os.path.splitext(basefilename)[0]
     pngfilename = f'{rootfilename}.png'
+    metricsfilename = f'{rootfilename}.olcfont'
 
     charwidth = 0
     charheight = 0
@@ -71,48 +71,93 @@ def GenerateFont( fontName, pointSize, fillColour=(255,255,255,255), outlineWidt
     # All glyphs will be offset by 'xoffset' when being pasted onto the png image
     xoffset = 2
 
-    # Construct the font png image - using an extra row which will contain the embedded font information
-    imageWidth = 16 * charwidth
-    imageHeight = (6 * charheight) + 1
-    fontimage = Image.new("RGBA", (imageWidth, imageHeight), (0,0,0,0) )
+    try:
+        check_page_size( maxPageSize )
+    except ValueError as e:
+        print( f"\n{e}\n" )
+        return
 
-    # Render each character into the png image
-    dc = ImageDraw.Draw( fontimage )
+    # Lay the glyphs out in 6 rows of 16 cells with the metrics in an extra row of pixels, which loads
+    # without the metrics file, whenever that fits on a page. A grayscale png has no room for the
+    # embedded metrics, so there the glyph cells - each only as wide as its glyph plus the offset -
+    # are packed tightly instead
+    grid = not alpha and 16 * charwidth <= maxPageSize and 6 * charheight + 1 <= maxPageSize
+    if grid:
+        positions = [ (0, (i % 16) * charwidth, (i // 16) * charheight) for i in range(len(chars)) ]
+        pages = [ (16 * charwidth, 6 * charheight + 1) ]
+    else:
+        try:
+            positions, pages = pack_glyphs( [ w + xoffset for w,h in charSizes ], charheight, maxPageSize )
+        except ValueError as e:
+            print( f"\n{e}\n" )
+            return
+        if len(pages) > 1:
+            print( f"\nThe glyphs do not fit on a single {maxPageSize}x{maxPageSize} page, try a larger page size\n" )
+            return
+
+    if alpha:
+        fontimages = [ Image.new("L", size, 0 ) for size in pages ]
+        fillColour, outlineColour = fillColour[3], outlineColour[3]
+    else:
+        fontimages = [ Image.new("RGBA", size, (0,0,0,0) ) for size in pages ]
+
+    # Render each character into its page
     for i,c in enumerate(chars):
-        dc.text( ((i % 16) * charwidth + xoffset + outlineWidth, (i // 16) * charheight + outlineWidth), c, font=font, fill=fillColour, stroke_width=outlineWidth, stroke_fill=outlineColour )
+        page, x, y = positions[i]
+        dc = ImageDraw.Draw( fontimages[page] )
+        dc.text( (x + xoffset + outlineWidth, y + outlineWidth), c, font=font, fill=fillColour, stroke_width=outlineWidth, stroke_fill=outlineColour )
 
     # Write the font information into the last row of pixels
-    # <"FONT"> <format_version> <xOffset> followed by 96 character widths
-    lastrow = fontimage.height - 1
-    format_version = 1
-    fontimage.putpixel( (0, lastrow), ( ord('F'), ord('O'), ord('N'), ord('T') )  )
-    fontimage.putpixel( (1, lastrow), _make_pixel(format_version) )
-    fontimage.putpixel( (2, lastrow), _make_pixel(xoffset) )
-    offset = 3
-    for c in charSizes:
-        fontimage.putpixel( (offset, lastrow), _make_pixel(c[0]) )
-        offset += 1
-
-    # Write the font png file with the font information embedded
-    fontimage.save( pngfilename )
-    print( f"Created font {pngfilename}" )
+    # <"FONT"> <format_version> <xOffset> followed by 96 character widths. Packed glyph rectangles live
+    # in the metrics file only, the last row then just carries the <"FONT"> <2> signature so the
+    # loaders can tell it from the grid. A grayscale png has no room for either
+    if grid:
+        lastrow = fontimages[0].height - 1
+        fontimages[0].putpixel( (0, lastrow), ( ord('F'), ord('O'), ord('N'), ord('T') )  )
+        fontimages[0].putpixel( (1, lastrow), make_pixel(1) )
+        fontimages[0].putpixel( (2, lastrow), make_pixel(xoffset) )
+        for i,c in enumerate(charSizes):
+            fontimages[0].putpixel( (3 + i, lastrow), make_pixel(c[0]) )
+    elif not alpha:
+        lastrow = fontimages[0].height - 1
+        fontimages[0].putpixel( (0, lastrow), ( ord('F'), ord('O'), ord('N'), ord('T') )  )
+        fontimages[0].putpixel( (1, lastrow), make_pixel(2) )
+
+    # Write the font png files - the first page is <font>.png, any others <font>_1.png, <font>_2.png ...
+    for page,image in enumerate(fontimages):
+        filename = pngfilename if page == 0 else f'{rootfilename}_{page}.png'
+        image.save( filename )
+        print( f"Created font {filename}" )
+
+    # And the glyph metrics
+    glyphs = []
+    for i,c in enumerate(chars):
+        page, x, y = positions[i]
+        glyphs.append( (ord(c), x + xoffset, y, charSizes[i][0], charheight - 1, charSizes[i][0], page) )
+    write_metrics( metricsfilename, charwidth, charheight, glyphs, len(pages), (ATLAS_COVERAGE if alpha else 0) | (ATLAS_GRID if grid else 0) )
+    print( f"Created font metrics {metricsfilename}" )
 
 
 
 def _fail_with_usage():
-    print( f"\nUsage: python generatefont.py <fontName> <pointSize>\n\n\tExample:  python generatefont.py Arial.ttf 30\n" )
+    print( f"\nUsage: python generatefont.py [--alpha] <fontName> <pointSize> [maxPageSize]\n\n\tExample:  python generatefont.py Arial.ttf 30\n" )
+    print( "--alpha writes an 8 bit grayscale png holding only the coverage of each pixel" )
+    print( "maxPageSize is the largest width and height of a png, 2048 unless given and at most 32767\n" )
     exit(1)
 
 
 if __name__ == "__main__":
-    if len(sys.argv) < 3:
+    args = [ a for a in sys.argv[1:] if a != "--alpha" ]
+    alpha = len(args) < len(sys.argv) - 1
+    if len(args) < 2:
         _fail_with_usage()
 
-    fontName, pointSize = sys.argv[1:3]
+    fontName, pointSize = args[0:2]
     try:
         pointSize = int(pointSize)
+        maxPageSize = int(args[2]) if len(args) > 2 else 2048
     except:
         _fail_with_usage()
 
-    GenerateFont( fontName, pointSize )
+    GenerateFont( fontName, pointSize, maxPageSize=maxPageSize, alpha=alpha )
     
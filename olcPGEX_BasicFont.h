@@ -0,0 +1,826 @@
+#pragma once
+
+#ifndef __OLC_PGEX_BASICFONT__
+#define __OLC_PGEX_BASICFONT__
+
+#include <vector>
+#include <memory>
+#include "olcPixelGameEngine.h"
+#include "olcPGEX_FontCommon.h"
+
+namespace olc
+{
+    // The font engine behind olc::Font and olc::CustomFont. The two only differ in their policies:
+    //
+    //     Lookup   loads the font and finds the glyph of a character - font::AsciiGlyphs
+    //              (olcPGEX_Font.h) or font::UnicodeGlyphs (olcPGEX_CustomFont.h)
+    //     Decoder  turns a string into the characters to look up - font::ByteDecoder or
+    //              font::Utf8Decoder (olcPGEX_FontCommon.h)
+    //
+    // Every loop is compiled once for monospaced and once for proportional text, so neither
+    // decides per character which it is. Use it through the Font and CustomFont aliases.
+    template<class Lookup, class Decoder>
+    class BasicFont : public olc::PGEX
+    {
+    public:
+        typedef Decoder TextDecoder;
+
+        BasicFont() = delete;
+        BasicFont(const std::string& sFontFile, olc::ResourcePack* pack = nullptr);
+
+        // Loads the png(s) and metrics without creating the decals, so it can run on any thread.
+        // Call CreateDecals() on the main thread; until then the decal functions draw nothing.
+        BasicFont(const std::string& sFontFile, olc::ResourcePack* pack, olc::font::DeferDecalsTag);
+        void CreateDecals();
+
+        olc::vi2d GetTextSize(std::string_view s);
+        olc::vi2d GetTextSizeProp(std::string_view s);
+
+        // Decode, look up and position a string once so it can be drawn repeatedly via the TextLayout overloads
+        olc::TextLayout LayoutText(std::string_view sText, bool bProportional = true);
+        void LayoutText(std::string_view sText, olc::TextLayout& layout, bool bProportional = true);
+
+        void DrawStringDecal(const olc::vf2d& pos, std::string_view sText, const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
+        void DrawRotatedStringDecal(const olc::vf2d& pos, std::string_view sText, const float fAngle, const olc::vf2d& center = {0.0f, 0.0f},
+                                    const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
+
+        void DrawStringPropDecal(const olc::vf2d& pos, std::string_view sText, const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
+        void DrawRotatedStringPropDecal(const olc::vf2d& pos, std::string_view sText, const float fAngle, const olc::vf2d& center = {0.0f, 0.0f},
+                                        const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
+
+        void DrawStringDecal(const olc::vf2d& pos, const olc::TextLayout& layout, const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
+        void DrawRotatedStringDecal(const olc::vf2d& pos, const olc::TextLayout& layout, const float fAngle, const olc::vf2d& center = {0.0f, 0.0f},
+                                    const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
+
+        // Draw a number, or strings and numbers strung together, without building a std::string:
+        // they are written into a font::FormatBuffer on the stack. DrawNumberDecal() is monospaced
+        // so changing digits don't shift; font::Fixed( f, n ) gives a number n decimals.
+        template<class T> void DrawNumberDecal(const olc::vf2d& pos, T value, const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
+        template<class... Args> void DrawFormattedDecal(const olc::vf2d& pos, const Pixel col, const Args&... args);
+        template<class... Args> void DrawFormattedPropDecal(const olc::vf2d& pos, const Pixel col, const Args&... args);
+
+        // Draws many strings at once, eg. the name tags of every unit on the map. The labels are
+        // laid out on SetLayoutThreads() threads, then submitted in the order given, so the
+        // result is the same however many threads there are. Joins the batch when batching.
+        void DrawLabelsDecal(const olc::TextLabel* pLabels, size_t nLabels);
+        void DrawLabelsDecal(const std::vector<olc::TextLabel>& vLabels);
+
+        // Threads DrawLabelsDecal() lays labels out on, counting the calling thread (default 1)
+        void SetLayoutThreads(uint32_t nThreads);
+
+        // Draw the glyph of nCodepoint in place of any character the font doesn't contain.
+        // CustomFont defaults to U+FFFD when the font has it, otherwise missing characters are left blank.
+        bool SetReplacementGlyph(uint32_t nCodepoint);
+
+        // The characters the font has glyphs for, see olc::FontChain
+        const olc::font::CoverageSet& Coverage() const;
+
+        // One line of text decoded already, for olc::FontChain: DrawCodepointsDecal() draws
+        // [pBegin, pEnd) at pos as DrawString(Prop)Decal() would and returns how far it moved the
+        // pen, in unscaled pixels. GetCodepointsAdvance() only measures.
+        float DrawCodepointsDecal(const olc::vf2d& pos, const uint32_t* pBegin, const uint32_t* pEnd, bool bProportional,
+                                  const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
+        float GetCodepointsAdvance(const uint32_t* pBegin, const uint32_t* pEnd, bool bProportional);
+
+        // Every Draw...Decal() call between BeginBatch() and EndBatch() is collected and submitted
+        // to the engine in EndBatch() as a single triangle list. Outside a batch each call is
+        // submitted on its own, still as one list per string rather than one decal per glyph.
+        void BeginBatch();
+        void EndBatch();
+
+        // DrawStringDecal() and DrawStringPropDecal() only emit the glyphs inside this rectangle,
+        // in screen pixels, and trim the ones on its edge. Lines entirely above or below it are
+        // skipped before they are decoded. Defaults to the whole screen, which ClearClipRect()
+        // goes back to. The rotated functions are not clipped.
+        void SetClipRect(const olc::vf2d& pos, const olc::vf2d& size);
+        void ClearClipRect();
+
+        // Software rendering straight into a sprite - no decals or GPU involved, so these work for
+        // render to texture, on worker threads and on headless machines. Glyphs are tinted by col
+        // and alpha blended over the sprite's existing contents.
+        void DrawString(olc::Sprite* target, const olc::vi2d& pos, std::string_view sText, const Pixel col = olc::WHITE, const uint32_t scale = 1);
+        void DrawStringProp(olc::Sprite* target, const olc::vi2d& pos, std::string_view sText, const Pixel col = olc::WHITE, const uint32_t scale = 1);
+        void DrawString(olc::Sprite* target, const olc::vi2d& pos, const olc::TextLayout& layout, const Pixel col = olc::WHITE, const uint32_t scale = 1);
+
+        // Split software rendered text into this many horizontal bands drawn on separate threads (default 1).
+        // The threads are started here and kept waiting for text, not started per string
+        void SetRasterThreads(uint32_t nThreads);
+
+        // Frees the atlas sprites once the decals have been created, for fonts that are only drawn
+        // with the decal functions. The software rendering functions draw nothing afterwards, and
+        // the first of them to be called says so on stdout.
+        void ReleaseSprites();
+
+        // Keeps the atlas as one byte of coverage per pixel instead of a 32 bit sprite, a quarter
+        // of the memory. Text is coloured by the tint alone, so only do this for white glyphs.
+        // Fonts generated with --alpha are always kept this way.
+        void CompactSprites();
+
+        // A number that tells this font apart from every other font the program has created, eg. to key caches on
+        uint64_t GetId() const;
+
+        // Memory held by the atlas sprites and by the textures of the decals, in bytes
+        size_t SpriteBytes() const;
+        size_t TextureBytes() const;
+
+#ifdef OLC_PGEX_FONT_STATS
+        // Lookups, misses, draws and load time of this font, see olc::font::FontStats
+        const olc::font::FontStats& GetStats() const;
+#endif
+
+    private:
+        // Per thread working space of the layout loops - the font's own on the main thread,
+        // one per worker in DrawLabelsDecal()
+        struct Scratch
+        {
+            std::vector<uint32_t>       vCodepoints;        // decoded text, reused between calls
+#ifdef OLC_PGEX_FONT_STATS
+            olc::font::FontStats        stats;
+#endif
+        };
+
+        template<bool bProportional> olc::vi2d TextSize(std::string_view s, Scratch& ctx) const;
+        template<bool bProportional> void Layout(std::string_view sText, olc::TextLayout& layout);
+        template<bool bProportional> void BatchString(olc::font::GlyphBatch& out, Scratch& ctx, const olc::font::ClipRect& clip,
+                                                      const olc::vf2d& pos, std::string_view sText, const Pixel col, const olc::vf2d& scale) const;
+        template<bool bProportional> void BatchRotatedString(olc::font::GlyphBatch& out, Scratch& ctx, const olc::vf2d& pos, std::string_view sText,
+                                                             const float fAngle, const olc::vf2d& center, const Pixel col, const olc::vf2d& scale) const;
+        template<bool bProportional> float BatchCodepoints(olc::font::GlyphBatch* out, Scratch& ctx, const olc::font::ClipRect& clip, const olc::vf2d& pos,
+                                                           const uint32_t* pBegin, const uint32_t* pEnd, const Pixel col, const olc::vf2d& scale) const;
+        void BatchLabel(olc::font::GlyphBatch& out, Scratch& ctx, const olc::font::ClipRect& clip, const olc::TextLabel& label) const;
+        olc::font::ClipRect ClipArea() const;
+        bool DecalsReady() const;
+        void SubmitBatch();
+
+    private:
+        std::vector<std::unique_ptr<olc::Sprite>>   vPageSprites;   // atlas pages, [0] is the png the font was loaded from
+        std::vector<olc::font::CoveragePage>        vPageCoverage;  // the atlas pages instead, once compacted
+        std::vector<std::unique_ptr<olc::Decal>>    vPageDecals;
+        olc::font::GlyphBatch           batch;
+        bool                            bBatching = false;
+        olc::font::ClipRect             clipRect;
+        bool                            bClipRect = false;      // otherwise clip to the screen
+        olc::TextLayout                 scratchLayout;
+        Scratch                         scratch;
+        std::unique_ptr<olc::font::WorkerPool>      rasterPool;
+        size_t                          nTextureBytes = 0;
+        bool                            bSpritesReleased = false;   // DrawString() to a sprite warns once after ReleaseSprites()
+
+        uint32_t                                    nLayoutThreads = 1;
+        std::unique_ptr<olc::font::WorkerPool>      pool;
+        std::vector<Scratch>                        vWorkerScratch;
+        std::vector<olc::font::GlyphBatch>          vLabelBatches;  // one per chunk of labels, merged in order
+
+        float                           fCharWidth = 0.0f;
+        float                           fCharHeight = 0.0f;
+        Lookup                          glyphs;
+        olc::font::CoverageSet          coverage;
+        olc::font::FontId               id;
+    };
+
+
+    template<class Lookup, class Decoder>
+    BasicFont<Lookup, Decoder>::BasicFont(const std::string& sFontFile, olc::ResourcePack* pack) : BasicFont( sFontFile, pack, olc::font::DeferDecals )
+    {
+        CreateDecals();
+    }
+
+
+    template<class Lookup, class Decoder>
+    BasicFont<Lookup, Decoder>::BasicFont(const std::string& sFontFile, olc::ResourcePack* pack, olc::font::DeferDecalsTag)
+    {
+        OLC_PGEX_FONT_STAT( scratch.stats.sName = sFontFile; olc::font::ScopeTimer loadTimer{ scratch.stats.fLoadSeconds }; )
+        olc::vi2d vCharSize = { 0, 0 };
+        bool bCoverage = false;
+        glyphs.Load( sFontFile, pack, vPageSprites, vCharSize, bCoverage );
+        glyphs.Coverage( coverage );
+        fCharWidth  = float(vCharSize.x);
+        fCharHeight = float(vCharSize.y);
+
+        // Grayscale pngs would draw as opaque boxes, they only make sense as coverage
+        if( bCoverage )
+            CompactSprites();
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::CreateDecals()
+    {
+        // Compacted pages are expanded to a white sprite just for the upload
+        const size_t nPages = std::max( vPageSprites.size(), vPageCoverage.size() );
+        while( vPageDecals.size() < nPages )
+        {
+            size_t i = vPageDecals.size();
+            std::unique_ptr<olc::Sprite> expanded;
+            olc::Sprite* sprite = i < vPageSprites.size() ? vPageSprites[i].get() : ( expanded = vPageCoverage[i].ToSprite() ).get();
+            vPageDecals.push_back( std::make_unique<olc::Decal>( sprite ) );
+            nTextureBytes += size_t(sprite->width) * size_t(sprite->height) * sizeof(olc::Pixel);
+            if( expanded )
+                vPageDecals.back()->sprite = nullptr;
+        }
+
+#ifdef OLC_PGEX_FONT_STATS
+        scratch.stats.nAtlasBytes = SpriteBytes();
+        scratch.stats.nTextureBytes = nTextureBytes;
+        olc::font::RegisterStats( &scratch.stats );
+#endif
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::ReleaseSprites()
+    {
+        // Not before the decals have been made from them
+        if( !DecalsReady() )
+            return;
+
+        for( auto& decal : vPageDecals )
+            decal->sprite = nullptr;
+        vPageSprites.clear();
+        vPageCoverage.clear();
+        bSpritesReleased = true;
+        OLC_PGEX_FONT_STAT( scratch.stats.nAtlasBytes = 0; )
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::CompactSprites()
+    {
+        for( auto& sprite : vPageSprites )
+            vPageCoverage.push_back( olc::font::CoveragePage::FromSprite( sprite.get() ) );
+        for( auto& decal : vPageDecals )
+            decal->sprite = nullptr;
+        vPageSprites.clear();
+        OLC_PGEX_FONT_STAT( scratch.stats.nAtlasBytes = SpriteBytes(); )
+    }
+
+
+    template<class Lookup, class Decoder>
+    size_t BasicFont<Lookup, Decoder>::SpriteBytes() const
+    {
+        size_t nBytes = 0;
+        for( auto& page : vPageSprites )
+            nBytes += size_t(page->width) * size_t(page->height) * sizeof(olc::Pixel);
+        for( auto& page : vPageCoverage )
+            nBytes += page.vData.size();
+        return nBytes;
+    }
+
+
+    template<class Lookup, class Decoder>
+    size_t BasicFont<Lookup, Decoder>::TextureBytes() const
+    {
+        return nTextureBytes;
+    }
+
+
+    template<class Lookup, class Decoder>
+    uint64_t BasicFont<Lookup, Decoder>::GetId() const
+    {
+        return id.Get();
+    }
+
+
+    template<class Lookup, class Decoder>
+    bool BasicFont<Lookup, Decoder>::SetReplacementGlyph(uint32_t nCodepoint)
+    {
+        return glyphs.SetReplacement( nCodepoint );
+    }
+
+
+    template<class Lookup, class Decoder>
+    const olc::font::CoverageSet& BasicFont<Lookup, Decoder>::Coverage() const
+    {
+        return coverage;
+    }
+
+
+    template<class Lookup, class Decoder>
+    olc::vi2d BasicFont<Lookup, Decoder>::GetTextSize(std::string_view s)
+    {
+        return TextSize<false>( s, scratch );
+    }
+
+
+    template<class Lookup, class Decoder>
+    olc::vi2d BasicFont<Lookup, Decoder>::GetTextSizeProp(std::string_view s)
+    {
+        return TextSize<true>( s, scratch );
+    }
+
+
+    template<class Lookup, class Decoder>
+    template<bool bProportional>
+    olc::vi2d BasicFont<Lookup, Decoder>::TextSize(std::string_view s, Scratch& ctx) const
+    {
+        olc::vi2d size = { 0,1 };
+        olc::vi2d pos = { 0,1 };
+        auto text = Decoder::Decode( s, ctx.vCodepoints );
+        OLC_PGEX_FONT_STAT( ctx.stats.Decoded( text.size() ); )
+        for( auto c : text )
+        {
+            if (c == '\n') { pos.y++;  pos.x = 0; }
+            else if constexpr( bProportional )
+            {
+                OLC_PGEX_FONT_STAT( ctx.stats.Lookup( glyphs.Contains( c ) ); )
+                pos.x += glyphs.template Find<true>( c ).advance;
+            }
+            else pos.x++;
+            size.x = std::max(size.x, pos.x);
+            size.y = std::max(size.y, pos.y);
+        }
+
+        if constexpr( bProportional )
+        {
+            size.y *= (int)fCharHeight;
+            return size;
+        }
+        else
+            return size * vf2d( fCharWidth, fCharHeight );
+    }
+
+
+    template<class Lookup, class Decoder>
+    olc::TextLayout BasicFont<Lookup, Decoder>::LayoutText(std::string_view sText, bool bProportional)
+    {
+        olc::TextLayout layout;
+        LayoutText( sText, layout, bProportional );
+        return layout;
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::LayoutText(std::string_view sText, olc::TextLayout& layout, bool bProportional)
+    {
+        if( bProportional )
+            Layout<true>( sText, layout );
+        else
+            Layout<false>( sText, layout );
+    }
+
+
+    template<class Lookup, class Decoder>
+    template<bool bProportional>
+    void BasicFont<Lookup, Decoder>::Layout(std::string_view sText, olc::TextLayout& layout)
+    {
+        layout.Clear();
+        layout.bProportional = bProportional;
+        layout.vGlyphs.reserve( sText.size() );
+        layout.vLineStarts.push_back( 0 );
+
+        olc::vf2d spos = { 0.0f, 0.0f };
+        float fWidth = 0.0f;
+        auto text = Decoder::Decode( sText, scratch.vCodepoints );
+        OLC_PGEX_FONT_STAT( scratch.stats.Decoded( text.size() ); )
+        for( auto c : text )
+        {
+            if (c == '\n')
+            {
+                spos.x = 0; spos.y += fCharHeight;
+                layout.vLineStarts.push_back( layout.vGlyphs.size() );
+            }
+            else
+            {
+                const auto& glyph = glyphs.template Find<bProportional>( c );
+                OLC_PGEX_FONT_STAT( scratch.stats.Lookup( glyphs.Contains( c ) ); )
+                layout.vGlyphs.push_back( { spos, glyph.pos, glyph.size, glyph.page } );
+                spos.x += bProportional ? float(glyph.advance) : fCharWidth;
+                fWidth = std::max( fWidth, spos.x );
+            }
+        }
+
+        layout.size = { int(fWidth), int(layout.vLineStarts.size()) * int(fCharHeight) };
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::DrawStringDecal(const olc::vf2d& pos, std::string_view sText, const Pixel col, const olc::vf2d& scale)
+    {
+        BatchString<false>( batch, scratch, ClipArea(), pos, sText, col, scale );
+        if( !bBatching )
+            SubmitBatch();
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::DrawStringPropDecal(const olc::vf2d& pos, std::string_view sText, const Pixel col, const olc::vf2d& scale)
+    {
+        BatchString<true>( batch, scratch, ClipArea(), pos, sText, col, scale );
+        if( !bBatching )
+            SubmitBatch();
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::DrawRotatedStringDecal(const olc::vf2d& pos, std::string_view sText, const float fAngle, const olc::vf2d& center, const Pixel col, const olc::vf2d& scale)
+    {
+        BatchRotatedString<false>( batch, scratch, pos, sText, fAngle, center, col, scale );
+        if( !bBatching )
+            SubmitBatch();
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::DrawRotatedStringPropDecal(const olc::vf2d& pos, std::string_view sText, const float fAngle, const olc::vf2d& center, const Pixel col, const olc::vf2d& scale)
+    {
+        BatchRotatedString<true>( batch, scratch, pos, sText, fAngle, center, col, scale );
+        if( !bBatching )
+            SubmitBatch();
+    }
+
+
+    template<class Lookup, class Decoder>
+    template<bool bProportional>
+    void BasicFont<Lookup, Decoder>::BatchString(olc::font::GlyphBatch& out, Scratch& ctx, const olc::font::ClipRect& clip,
+                                                 const olc::vf2d& pos, std::string_view sText, const Pixel col, const olc::vf2d& scale) const
+    {
+        if( !DecalsReady() )
+            return;
+
+        const float fLineHeight = fCharHeight * scale.y;
+        const float fMonoAdvance = fCharWidth * scale.x;
+        const bool bClip = scale.x > 0.0f && scale.y > 0.0f;
+
+        // Only the lines that can be seen are decoded at all. A '\n' byte is always a newline
+        // in utf-8, so the lines can be found before decoding
+        size_t nFirstLine = 0, nLastLine = SIZE_MAX;
+        if( bClip )
+            clip.VisibleLines( pos.y, fLineHeight, nFirstLine, nLastLine );
+        auto text = Decoder::Decode( olc::font::SliceLines( sText, nFirstLine, nLastLine ), ctx.vCodepoints );
+        OLC_PGEX_FONT_STAT( ctx.stats.Decoded( text.size() ); )
+
+        olc::vf2d spos = { 0.0f, float(nFirstLine) * fLineHeight };
+        for( auto it = text.begin(); it != text.end(); ++it )
+        {
+            const uint32_t c = *it;
+            if( c == '\n' )
+            {
+                spos.x = 0; spos.y += fLineHeight;
+                continue;
+            }
+
+            if( bClip && std::floor( pos.x + spos.x ) >= clip.br.x )
+            {
+                // Past the right edge, nothing more of this line can be seen
+                it = std::find( it, text.end(), typename Decoder::Char('\n') );
+                if( it == text.end() )
+                    break;
+                spos.x = 0; spos.y += fLineHeight;
+                continue;
+            }
+
+            const auto& glyph = glyphs.template Find<bProportional>( c );
+            OLC_PGEX_FONT_STAT( ctx.stats.Lookup( glyphs.Contains( c ) ); )
+            const olc::vf2d uvScale = vPageDecals[glyph.page]->vUVScale;
+            if( bClip )
+                out.AddClippedGlyph( pos + spos, glyph.pos, glyph.size, scale, uvScale, col, clip, glyph.page );
+            else
+                out.AddGlyph( pos + spos, glyph.pos, glyph.size, scale, uvScale, col, glyph.page );
+
+            if constexpr( bProportional )
+                spos.x += float(glyph.advance) * scale.x;
+            else
+                spos.x += fMonoAdvance;
+        }
+    }
+
+
+    template<class Lookup, class Decoder>
+    template<bool bProportional>
+    void BasicFont<Lookup, Decoder>::BatchRotatedString(olc::font::GlyphBatch& out, Scratch& ctx, const olc::vf2d& pos, std::string_view sText,
+                                                        const float fAngle, const olc::vf2d& center, const Pixel col, const olc::vf2d& scale) const
+    {
+        if( !DecalsReady() )
+            return;
+
+        // Laid out unrotated and unscaled, then moved into place with one transform
+        olc::vf2d spos = { 0.0f, 0.0f };
+        size_t nFirst = out.Corners();
+        auto text = Decoder::Decode( sText, ctx.vCodepoints );
+        OLC_PGEX_FONT_STAT( ctx.stats.Decoded( text.size() ); )
+        for( auto c : text )
+        {
+            if (c == '\n')
+            {
+                spos.x = 0; spos.y += fCharHeight;
+            }
+            else
+            {
+                const auto& glyph = glyphs.template Find<bProportional>( c );
+                OLC_PGEX_FONT_STAT( ctx.stats.Lookup( glyphs.Contains( c ) ); )
+                out.AddLocalGlyph( spos, glyph.pos, glyph.size, vPageDecals[glyph.page]->vUVScale, col, glyph.page );
+                spos.x += bProportional ? float(glyph.advance) : fCharWidth;
+            }
+        }
+
+        out.Transform( nFirst, olc::font::Affine::Rotation( pos, fAngle, center, scale ) );
+    }
+
+
+    template<class Lookup, class Decoder>
+    template<bool bProportional>
+    float BasicFont<Lookup, Decoder>::BatchCodepoints(olc::font::GlyphBatch* out, [[maybe_unused]] Scratch& ctx, const olc::font::ClipRect& clip, const olc::vf2d& pos,
+                                                      const uint32_t* pBegin, const uint32_t* pEnd, const Pixel col, const olc::vf2d& scale) const
+    {
+        if constexpr( !bProportional )
+        {
+            if( out == nullptr )
+                return fCharWidth * float( pEnd - pBegin );
+        }
+
+        // A line above or below the clip rectangle is only measured
+        if( out != nullptr && ( !DecalsReady() || scale.x <= 0.0f || scale.y <= 0.0f ) )
+            out = nullptr;
+        if( out != nullptr )
+        {
+            size_t nFirstLine, nLastLine;
+            clip.VisibleLines( pos.y, fCharHeight * scale.y, nFirstLine, nLastLine );
+            if( nFirstLine > 0 || nLastLine == 0 )
+                out = nullptr;
+        }
+
+        float fAdvance = 0.0f;
+        for( const uint32_t* p = pBegin; p != pEnd; p++ )
+        {
+            const auto& glyph = glyphs.template Find<bProportional>( *p );
+            OLC_PGEX_FONT_STAT( ctx.stats.Lookup( glyphs.Contains( *p ) ); )
+            if( out != nullptr && std::floor( pos.x + fAdvance * scale.x ) < clip.br.x )
+                out->AddClippedGlyph( { pos.x + fAdvance * scale.x, pos.y }, glyph.pos, glyph.size, scale, vPageDecals[glyph.page]->vUVScale, col, clip, glyph.page );
+            fAdvance += bProportional ? float( glyph.advance ) : fCharWidth;
+        }
+        return fAdvance;
+    }
+
+
+    template<class Lookup, class Decoder>
+    float BasicFont<Lookup, Decoder>::DrawCodepointsDecal(const olc::vf2d& pos, const uint32_t* pBegin, const uint32_t* pEnd, bool bProportional,
+                                                          const Pixel col, const olc::vf2d& scale)
+    {
+        const olc::font::ClipRect clip = ClipArea();
+        const float fAdvance = bProportional ? BatchCodepoints<true>( &batch, scratch, clip, pos, pBegin, pEnd, col, scale )
+                                             : BatchCodepoints<false>( &batch, scratch, clip, pos, pBegin, pEnd, col, scale );
+        if( !bBatching )
+            SubmitBatch();
+        return fAdvance;
+    }
+
+
+    template<class Lookup, class Decoder>
+    float BasicFont<Lookup, Decoder>::GetCodepointsAdvance(const uint32_t* pBegin, const uint32_t* pEnd, bool bProportional)
+    {
+        const olc::font::ClipRect clip;
+        return bProportional ? BatchCodepoints<true>( nullptr, scratch, clip, { 0.0f, 0.0f }, pBegin, pEnd, olc::WHITE, { 1.0f, 1.0f } )
+                             : BatchCodepoints<false>( nullptr, scratch, clip, { 0.0f, 0.0f }, pBegin, pEnd, olc::WHITE, { 1.0f, 1.0f } );
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::BatchLabel(olc::font::GlyphBatch& out, Scratch& ctx, const olc::font::ClipRect& clip, const olc::TextLabel& label) const
+    {
+        olc::vf2d size = { 0.0f, 0.0f };
+        if( label.align.x != 0.0f || label.align.y != 0.0f )
+            size = label.bProportional ? TextSize<true>( label.sText, ctx ) : TextSize<false>( label.sText, ctx );
+
+        if( label.fAngle != 0.0f )
+        {
+            // Rotate about the aligned point
+            if( label.bProportional )
+                BatchRotatedString<true>( out, ctx, label.pos, label.sText, label.fAngle, label.align * size, label.col, label.scale );
+            else
+                BatchRotatedString<false>( out, ctx, label.pos, label.sText, label.fAngle, label.align * size, label.col, label.scale );
+            return;
+        }
+
+        olc::vf2d pos = label.pos - label.align * size * label.scale;
+        if( label.bProportional )
+            BatchString<true>( out, ctx, clip, pos, label.sText, label.col, label.scale );
+        else
+            BatchString<false>( out, ctx, clip, pos, label.sText, label.col, label.scale );
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::DrawStringDecal(const olc::vf2d& pos, const olc::TextLayout& layout, const Pixel col, const olc::vf2d& scale)
+    {
+        if( !DecalsReady() )
+            return;
+        olc::font::BatchLayout( batch, vPageDecals.data(), pos, layout, col, scale, ClipArea() );
+        if( !bBatching )
+            SubmitBatch();
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::DrawRotatedStringDecal(const olc::vf2d& pos, const olc::TextLayout& layout, const float fAngle, const olc::vf2d& center, const Pixel col, const olc::vf2d& scale)
+    {
+        if( !DecalsReady() )
+            return;
+        olc::font::BatchRotatedLayout( batch, vPageDecals.data(), pos, layout, fAngle, center, col, scale );
+        if( !bBatching )
+            SubmitBatch();
+    }
+
+
+    template<class Lookup, class Decoder>
+    template<class T>
+    void BasicFont<Lookup, Decoder>::DrawNumberDecal(const olc::vf2d& pos, T value, const Pixel col, const olc::vf2d& scale)
+    {
+        DrawStringDecal( pos, olc::font::FormatBuffer<64>( value ), col, scale );
+    }
+
+
+    template<class Lookup, class Decoder>
+    template<class... Args>
+    void BasicFont<Lookup, Decoder>::DrawFormattedDecal(const olc::vf2d& pos, const Pixel col, const Args&... args)
+    {
+        DrawStringDecal( pos, olc::font::FormatBuffer<>( args... ), col );
+    }
+
+
+    template<class Lookup, class Decoder>
+    template<class... Args>
+    void BasicFont<Lookup, Decoder>::DrawFormattedPropDecal(const olc::vf2d& pos, const Pixel col, const Args&... args)
+    {
+        DrawStringPropDecal( pos, olc::font::FormatBuffer<>( args... ), col );
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::DrawLabelsDecal(const olc::TextLabel* pLabels, size_t nLabels)
+    {
+        if( !DecalsReady() )
+            return;
+
+        const olc::font::ClipRect clip = ClipArea();
+
+        // Labels are handed to the threads in chunks, each chunk filling its own batch
+        constexpr size_t nChunkSize = 32;
+        const size_t nChunks = ( nLabels + nChunkSize - 1 ) / nChunkSize;
+        if( pool == nullptr || nChunks < 2 )
+        {
+            for( size_t i = 0; i < nLabels; i++ )
+                BatchLabel( batch, scratch, clip, pLabels[i] );
+        }
+        else
+        {
+            if( vLabelBatches.size() < nChunks )
+                vLabelBatches.resize( nChunks );
+
+            pool->Run( nChunks, [&]( size_t nChunk, uint32_t nWorker )
+            {
+                size_t nEnd = std::min( ( nChunk + 1 ) * nChunkSize, nLabels );
+                for( size_t i = nChunk * nChunkSize; i < nEnd; i++ )
+                    BatchLabel( vLabelBatches[nChunk], vWorkerScratch[nWorker], clip, pLabels[i] );
+            } );
+
+            // Merge in label order, so the draw order doesn't depend on the threads
+            for( size_t i = 0; i < nChunks; i++ )
+                batch.Append( vLabelBatches[i] );
+
+#ifdef OLC_PGEX_FONT_STATS
+            for( auto& worker : vWorkerScratch )
+            {
+                scratch.stats.Add( worker.stats.frame );
+                worker.stats.frame = olc::font::FontStats::Counters();
+            }
+#endif
+        }
+
+        if( !bBatching )
+            SubmitBatch();
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::DrawLabelsDecal(const std::vector<olc::TextLabel>& vLabels)
+    {
+        DrawLabelsDecal( vLabels.data(), vLabels.size() );
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::SetLayoutThreads(uint32_t nThreads)
+    {
+        nLayoutThreads = std::max( nThreads, 1u );
+        pool.reset();
+        vWorkerScratch.clear();
+        if( nLayoutThreads > 1 )
+        {
+            pool = std::make_unique<olc::font::WorkerPool>( nLayoutThreads );
+            vWorkerScratch.resize( pool->Workers() );
+        }
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::SetClipRect(const olc::vf2d& pos, const olc::vf2d& size)
+    {
+        clipRect = { pos, pos + size };
+        bClipRect = true;
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::ClearClipRect()
+    {
+        bClipRect = false;
+    }
+
+
+    template<class Lookup, class Decoder>
+    olc::font::ClipRect BasicFont<Lookup, Decoder>::ClipArea() const
+    {
+        if( bClipRect )
+            return clipRect;
+        return { { 0.0f, 0.0f }, olc::vf2d( float(pge->ScreenWidth()), float(pge->ScreenHeight()) ) };
+    }
+
+
+    template<class Lookup, class Decoder>
+    bool BasicFont<Lookup, Decoder>::DecalsReady() const
+    {
+        // Fonts constructed with olc::font::DeferDecals draw nothing until CreateDecals()
+        return !vPageDecals.empty() && vPageDecals.size() >= std::max( vPageSprites.size(), vPageCoverage.size() );
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::BeginBatch()
+    {
+        bBatching = true;
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::EndBatch()
+    {
+        bBatching = false;
+        SubmitBatch();
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::DrawString(olc::Sprite* target, const olc::vi2d& pos, std::string_view sText, const Pixel col, const uint32_t scale)
+    {
+        Layout<false>( sText, scratchLayout );
+        DrawString( target, pos, scratchLayout, col, scale );
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::DrawStringProp(olc::Sprite* target, const olc::vi2d& pos, std::string_view sText, const Pixel col, const uint32_t scale)
+    {
+        Layout<true>( sText, scratchLayout );
+        DrawString( target, pos, scratchLayout, col, scale );
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::DrawString(olc::Sprite* target, const olc::vi2d& pos, const olc::TextLayout& layout, const Pixel col, const uint32_t scale)
+    {
+        if( vPageSprites.empty() && vPageCoverage.empty() )
+        {
+            if( bSpritesReleased )
+                printf( "DrawString() into a sprite after ReleaseSprites() draws nothing\n" );
+            bSpritesReleased = false;
+            return;
+        }
+        OLC_PGEX_FONT_STAT( scratch.stats.Drawn( layout.vGlyphs.size(), 0 ); )
+        if( !vPageCoverage.empty() )
+            olc::font::RasterLayout( target, vPageCoverage.data(), vPageCoverage.size(), pos, layout, col, scale, rasterPool.get() );
+        else
+            olc::font::RasterLayout( target, vPageSprites.data(), vPageSprites.size(), pos, layout, col, scale, rasterPool.get() );
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::SetRasterThreads(uint32_t nThreads)
+    {
+        rasterPool.reset();
+        if( nThreads > 1 )
+            rasterPool = std::make_unique<olc::font::WorkerPool>( nThreads );
+    }
+
+
+    template<class Lookup, class Decoder>
+    void BasicFont<Lookup, Decoder>::SubmitBatch()
+    {
+#ifdef OLC_PGEX_FONT_STATS
+        size_t nGlyphs = batch.Quads();
+        scratch.stats.Drawn( nGlyphs, batch.Submit( pge, vPageDecals.data(), vPageDecals.size() ) );
+#else
+        batch.Submit( pge, vPageDecals.data(), vPageDecals.size() );
+#endif
+    }
+
+
+#ifdef OLC_PGEX_FONT_STATS
+    template<class Lookup, class Decoder>
+    const olc::font::FontStats& BasicFont<Lookup, Decoder>::GetStats() const
+    {
+        return scratch.stats;
+    }
+#endif
+}
+
+#endif
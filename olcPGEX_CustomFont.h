@@ -6,35 +6,51 @@
 #include <vector>
 #include <memory>
 #include "olcPixelGameEngine.h"
+#include "olcPGEX_FontCommon.h"
+#include "olcPGEX_BasicFont.h"
 
 namespace olc
 {
-    class CustomFont : public olc::PGEX
+    namespace font
     {
-    public:
-        CustomFont() = delete;
-        CustomFont(const std::string& sFontFile, olc::ResourcePack* pack = nullptr);
-
-        olc::vi2d GetTextSize(const std::string& s);
-        olc::vi2d GetTextSizeProp(const std::string& s);
-        
-        void DrawStringDecal(const olc::vf2d& pos, const std::string& sText, const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
-        void DrawRotatedStringDecal(const olc::vf2d& pos, const std::string& sText, const float fAngle, const olc::vf2d& center = {0.0f, 0.0f},  
-                                    const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
-
-        void DrawStringPropDecal(const olc::vf2d& pos, const std::string& sText, const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
-        void DrawRotatedStringPropDecal(const olc::vf2d& pos, const std::string& sText, const float fAngle, const olc::vf2d& center = {0.0f, 0.0f},  
-                                        const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
-
-    private:
-        std::unique_ptr<olc::Sprite>    fontSprite;
-        std::unique_ptr<olc::Decal>     fontDecal;
-
-        float                           fCharWidth;
-        float                           fCharHeight;
-        std::unordered_map<uint32_t, std::pair<olc::vi2d, olc::vi2d> > mGlyphPositionsMono;
-        std::unordered_map<uint32_t, std::pair<olc::vi2d, olc::vi2d> > mGlyphPositionsProp;
-    };
+        // Glyph lookup of olc::CustomFont: any set of unicode characters, made by
+        // generatecustomfont.py, found through a GlyphTable. The glyphs may be spread over
+        // several atlas pages.
+        class UnicodeGlyphs
+        {
+        public:
+            void Load(const std::string& sFontFile, olc::ResourcePack* pack, std::vector<std::unique_ptr<olc::Sprite>>& vPages, olc::vi2d& vCharSize, bool& bCoverage);
+
+            // Monospaced glyphs laid out in a grid - pngs with embedded metrics, or ATLAS_GRID in the
+            // .olcfont - are drawn from the whole cell, as olc::Font draws them, proportional ones
+            // only as wide as they advance. Packed glyphs have no cell around them and are drawn
+            // from their own rectangle
+            template<bool bProportional>
+            decltype(auto) Find( uint32_t c ) const
+            {
+                if constexpr( bProportional )
+                    return table.Find( c );
+                else
+                {
+                    Glyph glyph = table.Find( c );
+                    if( monoSize.x > 0 && glyph.size.y > 0 )    // not the blank replacement
+                        glyph.size = monoSize;
+                    return glyph;
+                }
+            }
+
+            bool Contains( uint32_t c ) const { return table.Contains( c ); }
+            void Coverage( CoverageSet& set ) const { table.Coverage( set ); }
+            bool SetReplacement( uint32_t c ) { return table.SetReplacement( c ); }
+
+        private:
+            GlyphTable table;
+            olc::vi2d  monoSize;        // cell of a grid layout, 0 when packed
+        };
+    }
+
+    typedef BasicFont<olc::font::UnicodeGlyphs, olc::font::Utf8Decoder> CustomFont;
+    extern template class BasicFont<olc::font::UnicodeGlyphs, olc::font::Utf8Decoder>;
 }
 
 
@@ -43,24 +59,37 @@ namespace olc
 
 namespace olc
 {
-    uint32_t _next_utf8_codepoint( const std::string& s, int& i )
-    {
-        uint32_t c;
-        uint8_t mask = (uint8_t)s[i] & 0xf0;
-        if( mask == 0xf0 ) { c = ((uint32_t)s[i] & 0x07) << 18 | ((uint32_t)s[i+1] & 0x3f) << 12 | ((uint32_t)s[i+2] & 0x3f) << 6 | s[i+3] & 0x3f; i+=4; }
-        else if( mask == 0xe0 ) { c = ((uint32_t)s[i] & 0x0f) << 12 | ((uint32_t)s[i+1] & 0x3f) << 6 | s[i+2] & 0x3f; i+=3; } 
-        else if( (mask & 0xe0) == 0xc0 ) { c = ((uint32_t)s[i] & 0x1f) << 6 | s[i+1] & 0x3f; i+=2; }
-        else { c = s[i]; i++; }
-        return c;
-    }
+    template class BasicFont<olc::font::UnicodeGlyphs, olc::font::Utf8Decoder>;
 
 
-    CustomFont::CustomFont(const std::string& sFontFile, olc::ResourcePack* pack)
+    void font::UnicodeGlyphs::Load(const std::string& sFontFile, olc::ResourcePack* pack, std::vector<std::unique_ptr<olc::Sprite>>& vPages, olc::vi2d& vCharSize, bool& bCoverage)
     {
-        fontSprite = std::make_unique<olc::Sprite>( sFontFile, pack );
-        fontDecal = std::make_unique<olc::Decal>( fontSprite.get() );
+        vPages.push_back( std::make_unique<olc::Sprite>( sFontFile, pack ) );
 
-        // Find the CFON signature and extract the embedded font information
+        // Prefer the metrics file written alongside the png - it saves searching the image for the data rows
+        std::vector<uint32_t> vMetricsData;
+        olc::font::MetricsView metrics;
+        if( olc::font::LoadMetrics( sFontFile, pack, vMetricsData, metrics ) )
+        {
+            // Glyphs that didn't fit on the first page are on <font>_1.png, <font>_2.png ...
+            for( uint32_t i = 1; i < metrics.Header().nPages; i++ )
+                vPages.push_back( std::make_unique<olc::Sprite>( olc::font::PageFileName( sFontFile, i ), pack ) );
+
+            for( const auto& g : metrics )
+                if( g.nPage < vPages.size() )
+                    table.Add( { {g.x, g.y}, {g.w, g.h}, g.nAdvance, g.nCodepoint, g.nPage, {0,0} } );
+
+            table.SetReplacement( 0xFFFD );
+
+            if( metrics.Header().nFlags & olc::font::ATLAS_GRID )
+                monoSize = { int(metrics.Header().nCharWidth), int(metrics.Header().nCharHeight) - 1 };
+            vCharSize = { int(metrics.Header().nCharWidth), int(metrics.Header().nCharHeight) };
+            bCoverage = ( metrics.Header().nFlags & olc::font::ATLAS_COVERAGE ) != 0;
+            return;
+        }
+
+        // Otherwise find the CFON signature and extract the embedded font information
+        olc::Sprite* fontSprite = vPages[0].get();
         int dataRow = -1;
         for( auto i = fontSprite->height-1; dataRow<0 && i>-1; i-- )
         {
@@ -72,6 +101,13 @@ namespace olc
         {
             // CFON signature found - presume the pixels contain valid font information
             uint32_t nFormatVersion = fontSprite->GetPixel( 1, dataRow ).n;
+            if( nFormatVersion > 1 )
+            {
+                // Packed fonts keep their glyph rectangles in the .olcfont file only
+                printf( "%s needs its metrics file %s\n", sFontFile.c_str(), olc::font::MetricsFileName( sFontFile ).c_str() );
+                return;
+            }
+
             uint32_t nGlyphs        = fontSprite->GetPixel( 2, dataRow ).n;
             int nOffset             = fontSprite->GetPixel( 3, dataRow ).n;
             int nCharWidth          = fontSprite->GetPixel( 4, dataRow ).n;
@@ -87,12 +123,13 @@ namespace olc
                 uint32_t nGlyph     = fontSprite->GetPixel( pixelX+1, pixelY ).n;
                 int x               = i % nCharsPerRow * nCharWidth + nOffset;
                 int y               = i / nCharsPerRow * nCharHeight;
-                mGlyphPositionsMono.emplace( nGlyph, std::make_pair<olc::vi2d, olc::vi2d>( {x,y}, {nCharWidth,nCharHeight-1}) );
-                mGlyphPositionsProp.emplace( nGlyph, std::make_pair<olc::vi2d, olc::vi2d>( {x,y}, {nWidth, nCharHeight-1}) );
+                table.Add( { {x,y}, {nWidth, nCharHeight-1}, nWidth, nGlyph, 0, {0,0} } );
             }
 
-            fCharWidth = float(nCharWidth);
-            fCharHeight = float(nCharHeight);
+            table.SetReplacement( 0xFFFD );
+
+            monoSize = { nCharWidth, nCharHeight-1 };
+            vCharSize = { nCharWidth, nCharHeight };
         }
         else
         {
@@ -100,121 +137,7 @@ namespace olc
             printf( "%s is not a valid custom font\n", sFontFile.c_str() );
         }
     }
-
-
-    olc::vi2d CustomFont::GetTextSize(const std::string& s)
-    {
-        olc::vi2d size = { 0,1 };
-        olc::vi2d pos = { 0,1 };
-        for( int i=0; i < (int)s.size(); )
-        {
-            uint32_t c = _next_utf8_codepoint( s, i );
-            if (c == '\n') { pos.y++;  pos.x = 0; }
-            else pos.x++;
-            size.x = std::max(size.x, pos.x);
-            size.y = std::max(size.y, pos.y);
-        }
-        return size * vf2d( fCharWidth, fCharHeight );
-    }
-
-    
-    olc::vi2d CustomFont::GetTextSizeProp(const std::string& s)
-    {
-        olc::vi2d size = { 0,1 };
-        olc::vi2d pos = { 0,1 };
-        for( int i=0; i < (int)s.size(); )
-        {
-            uint32_t c = _next_utf8_codepoint( s, i );
-            if (c == '\n') { pos.y += 1 ;  pos.x = 0; }
-            else pos.x += mGlyphPositionsProp[c].second.x;
-            size.x = std::max(size.x, pos.x);
-            size.y = std::max(size.y, pos.y);
-        }
-
-        size.y *= (int)fCharHeight;
-        return size;
-    }
-    
-
-    void CustomFont::DrawStringDecal(const olc::vf2d& pos, const std::string& sText, const Pixel col, const olc::vf2d& scale)
-    {
-        olc::vf2d spos = { 0.0f, 0.0f };
-        for( int i=0; i < (int)sText.size(); )
-        {
-            uint32_t c = _next_utf8_codepoint( sText, i );
-            if (c == '\n')
-            {
-                spos.x = 0; spos.y += fCharHeight * scale.y;
-            }
-            else
-            {
-                auto& glyph = mGlyphPositionsMono[c];
-                pge->DrawPartialDecal(pos + spos, fontDecal.get(), glyph.first, glyph.second, scale, col);
-                spos.x += fCharWidth * scale.x;
-            }
-        }
-    }
-
-    
-    void CustomFont::DrawRotatedStringDecal(const olc::vf2d& pos, const std::string& sText, const float fAngle, const olc::vf2d& center, const Pixel col, const olc::vf2d& scale )
-    {
-        olc::vf2d spos = center;
-        for( int i=0; i < (int)sText.size(); )
-        {
-            uint32_t c = _next_utf8_codepoint( sText, i );
-            if (c == '\n')
-            {
-                spos.x = center.x; spos.y -= fCharHeight;
-            }
-            else
-            {
-                auto& glyph = mGlyphPositionsMono[c];
-                pge->DrawPartialRotatedDecal(pos, fontDecal.get(), fAngle, spos, glyph.first, glyph.second, scale, col);
-                spos.x -= fCharWidth;
-            }
-        }
-    }
-
-
-    void CustomFont::DrawStringPropDecal(const olc::vf2d& pos, const std::string& sText, const Pixel col, const olc::vf2d& scale)
-    {
-        olc::vf2d spos = { 0.0f, 0.0f };
-        for( int i=0; i < (int)sText.size(); )
-        {
-            uint32_t c = _next_utf8_codepoint( sText, i );
-            if (c == '\n')
-            {
-                spos.x = 0; spos.y += fCharHeight * scale.y;
-            }
-            else
-            {
-                auto& glyph = mGlyphPositionsProp[c];
-                pge->DrawPartialDecal(pos + spos, fontDecal.get(), glyph.first, glyph.second, scale, col);
-                spos.x += glyph.second.x * scale.x;
-            }
-        }
-    }
-
-
-    void CustomFont::DrawRotatedStringPropDecal(const olc::vf2d& pos, const std::string& sText, const float fAngle, const olc::vf2d& center, const Pixel col, const olc::vf2d& scale )
-    {
-        olc::vf2d spos = center;
-        for( int i=0; i < (int)sText.size(); )
-        {
-            uint32_t c = _next_utf8_codepoint( sText, i );
-            if (c == '\n')
-            {
-                spos.x = center.x; spos.y -= fCharHeight;
-            }
-            else
-            {
-                auto& glyph = mGlyphPositionsProp[c];
-                pge->DrawPartialRotatedDecal(pos, fontDecal.get(), fAngle, spos, glyph.first, glyph.second, scale, col);
-                spos.x -= glyph.second.x;
-            }
-        }
-    }
 }
- 
+
 #endif
 #endif
@@ -0,0 +1,449 @@
+#pragma once
+
+#ifndef __OLC_PGEX_DYNAMICFONT__
+#define __OLC_PGEX_DYNAMICFONT__
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "olcPixelGameEngine.h"
+#include "olcPGEX_FontCommon.h"
+#include "olcPGEX_TrueType.h"
+
+namespace olc
+{
+    // A font that loads a truetype file directly and rasterises glyphs into a fixed size atlas the
+    // first time they are drawn, so any character in the font can be used without baking a png.
+    // Glyphs are packed onto shelves; when the atlas is full the shelf used least recently (and not
+    // during the current frame) is cleared and reused. Changes to the atlas are uploaded once per
+    // frame, after OnUserUpdate().
+    //
+    // Reads the font and rasterises its glyphs with olcPGEX_TrueType.h, which has to be next to
+    // this header. Fonts with CFF outlines aren't supported.
+    //
+    // DynamicFont hooks into the engine, so create it once the engine is running (OnUserCreate)
+    // and keep it for the lifetime of the engine.
+    class DynamicFont : public olc::PGEX
+    {
+    public:
+        typedef olc::font::Utf8Decoder TextDecoder;
+
+        struct Stats
+        {
+            uint64_t    nRasterised     = 0;    // glyphs drawn into the atlas
+            uint64_t    nEvictedGlyphs  = 0;
+            uint64_t    nEvictedShelves = 0;
+            uint64_t    nUploads        = 0;    // atlas uploads to the GPU
+            size_t      nGlyphs         = 0;    // glyphs currently in the atlas
+        };
+
+    public:
+        DynamicFont() = delete;
+        DynamicFont(const std::string& sFontFile, float fPixelHeight, olc::ResourcePack* pack = nullptr, const olc::vi2d& vAtlasSize = { 1024, 1024 });
+
+        olc::vi2d GetTextSize(std::string_view s);
+        olc::vi2d GetTextSizeProp(std::string_view s);
+
+        void DrawStringDecal(const olc::vf2d& pos, std::string_view sText, const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
+        void DrawRotatedStringDecal(const olc::vf2d& pos, std::string_view sText, const float fAngle, const olc::vf2d& center = {0.0f, 0.0f},
+                                    const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
+
+        void DrawStringPropDecal(const olc::vf2d& pos, std::string_view sText, const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
+        void DrawRotatedStringPropDecal(const olc::vf2d& pos, std::string_view sText, const float fAngle, const olc::vf2d& center = {0.0f, 0.0f},
+                                        const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
+
+        void BeginBatch();
+        void EndBatch();
+
+        void DrawString(olc::Sprite* target, const olc::vi2d& pos, std::string_view sText, const Pixel col = olc::WHITE, const uint32_t scale = 1);
+        void DrawStringProp(olc::Sprite* target, const olc::vi2d& pos, std::string_view sText, const Pixel col = olc::WHITE, const uint32_t scale = 1);
+
+        // Characters the font doesn't have are drawn as this one (default U+FFFD if the font has it)
+        void SetReplacementGlyph(uint32_t nCodepoint);
+
+        // Uploads any glyphs rasterised since the last upload. Called automatically after OnUserUpdate()
+        void Flush();
+
+        const Stats& GetStats() const;
+
+    protected:
+        void OnAfterUserUpdate(float fElapsedTime) override;
+
+    private:
+        struct Shelf
+        {
+            int32_t                 y = 0;
+            int32_t                 height = 0;
+            int32_t                 x = 0;              // next free column
+            uint64_t                nLastUsed = 0;      // frame the shelf was last drawn from
+            std::vector<uint32_t>   vCodepoints;
+        };
+
+        olc::font::Glyph Fetch(uint32_t nCodepoint);
+        bool Rasterise(uint32_t nCodepoint, int nGlyphIndex);
+        bool Allocate(const olc::vi2d& size, olc::vi2d& pos);
+        void LayoutText(std::string_view sText, bool bProportional);
+
+    private:
+        std::unique_ptr<olc::Sprite>    fontSprite;
+        std::unique_ptr<olc::Decal>     fontDecal;
+        olc::font::GlyphBatch           batch;
+        bool                            bBatching = false;
+        olc::TextLayout                 scratchLayout;
+        std::vector<uint32_t>           vCodepoints;        // decoded text, reused between calls
+
+        std::vector<unsigned char>      vFontData;
+        olc::font::ttf::FontInfo       fontInfo;
+        bool                            bValid = false;
+        float                           fScale = 1.0f;
+        int32_t                         nBaseline = 0;
+        uint32_t                        nReplacement = 0;
+
+        float                           fCharWidth = 0.0f;
+        float                           fCharHeight = 0.0f;
+        olc::font::GlyphTable           glyphs;
+        olc::font::CoverageSet          missing;            // codepoints the font has no glyph for
+
+        std::vector<Shelf>              vShelves;
+        std::vector<uint16_t>           vShelfOfRow;        // shelf index of each atlas row
+        int32_t                         nNextShelfY = 0;
+        uint64_t                        nFrame = 1;
+        bool                            bDirty = false;
+        std::vector<unsigned char>      vBitmap;
+        Stats                           stats;
+    };
+}
+
+
+#ifdef OLC_PGEX_DYNAMICFONT
+#undef OLC_PGEX_DYNAMICFONT
+
+#include <fstream>
+#include <iterator>
+
+namespace olc
+{
+    DynamicFont::DynamicFont(const std::string& sFontFile, float fPixelHeight, olc::ResourcePack* pack, const olc::vi2d& vAtlasSize) : olc::PGEX(true)
+    {
+        fontSprite = std::make_unique<olc::Sprite>( vAtlasSize.x, vAtlasSize.y );
+        for( int i = 0; i < vAtlasSize.x * vAtlasSize.y; i++ )
+            fontSprite->GetData()[i] = olc::BLANK;
+        fontDecal = std::make_unique<olc::Decal>( fontSprite.get() );
+        vShelfOfRow.assign( size_t( vAtlasSize.y ), 0 );
+
+        if( pack != nullptr )
+        {
+            auto buffer = pack->GetFileBuffer( sFontFile );
+            vFontData.assign( buffer.vMemory.begin(), buffer.vMemory.end() );
+        }
+        else
+        {
+            std::ifstream file( sFontFile, std::ios::binary );
+            vFontData.assign( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+        }
+
+        if( vFontData.empty() || !olc::font::ttf::InitFont( fontInfo, vFontData.data(), vFontData.size(), olc::font::ttf::GetFontOffsetForIndex( vFontData.data(), vFontData.size(), 0 ) ) )
+        {
+            printf( "%s is not a valid truetype font\n", sFontFile.c_str() );
+            return;
+        }
+
+        bValid = true;
+        fScale = olc::font::ttf::ScaleForPixelHeight( fontInfo, fPixelHeight );
+
+        int nAscent, nDescent, nLineGap;
+        olc::font::ttf::GetFontVMetrics( fontInfo, nAscent, nDescent, nLineGap );
+        nBaseline = int32_t( std::ceil( nAscent * fScale ) );
+        fCharHeight = std::ceil( ( nAscent - nDescent + nLineGap ) * fScale );
+
+        int x0, y0, x1, y1;
+        olc::font::ttf::GetFontBoundingBox( fontInfo, x0, y0, x1, y1 );
+        fCharWidth = std::ceil( ( x1 - x0 ) * fScale );
+
+        if( olc::font::ttf::FindGlyphIndex( fontInfo, 0xFFFD ) != 0 )
+            nReplacement = 0xFFFD;
+    }
+
+
+    olc::font::Glyph DynamicFont::Fetch(uint32_t nCodepoint)
+    {
+        if( !glyphs.Contains( nCodepoint ) )
+        {
+            // Codepoints found missing once are remembered, so the font's tables are searched only once
+            int nGlyphIndex = bValid && !missing.Contains( nCodepoint ) ? olc::font::ttf::FindGlyphIndex( fontInfo, nCodepoint ) : 0;
+            if( nGlyphIndex == 0 )
+            {
+                missing.Add( nCodepoint );
+                return nCodepoint != nReplacement && nReplacement != 0 ? Fetch( nReplacement ) : olc::font::Glyph();
+            }
+            if( !Rasterise( nCodepoint, nGlyphIndex ) )
+                return olc::font::Glyph();      // atlas full of glyphs drawn this frame
+        }
+
+        const olc::font::Glyph& glyph = glyphs.Find( nCodepoint );
+        if( glyph.size.y > 0 )
+            vShelves[ vShelfOfRow[glyph.pos.y] ].nLastUsed = nFrame;
+        return glyph;
+    }
+
+
+    bool DynamicFont::Rasterise(uint32_t nCodepoint, int nGlyphIndex)
+    {
+        int nAdvance, nBearing;
+        olc::font::ttf::GetGlyphHMetrics( fontInfo, nGlyphIndex, nAdvance, nBearing );
+
+        int x0, y0, x1, y1;
+        olc::font::ttf::GetGlyphBitmapBox( fontInfo, nGlyphIndex, fScale, fScale, x0, y0, x1, y1 );
+
+        // Each glyph gets a cell just the size of its ink, drawn offset from the pen position, so
+        // negative bearings and ink overhanging the advance or the line are kept whole
+        olc::font::Glyph glyph;
+        glyph.codepoint = nCodepoint;
+        glyph.advance   = std::max( int32_t( std::lround( nAdvance * fScale ) ), 1 );
+
+        if( x1 <= x0 || y1 <= y0 )
+        {
+            // Nothing to draw (a space) - only the advance matters, no atlas space is needed
+            glyph.size = { 0, 0 };
+            glyphs.Add( glyph );
+            return true;
+        }
+
+        glyph.size   = { x1 - x0, y1 - y0 };
+        glyph.offset = { x0, nBaseline + y0 };
+        if( !Allocate( glyph.size, glyph.pos ) )
+            return false;
+
+        int w = glyph.size.x, h = glyph.size.y;
+        vBitmap.assign( size_t( w ) * size_t( h ), 0 );
+        olc::font::ttf::MakeGlyphBitmap( fontInfo, vBitmap.data(), w, h, w, fScale, fScale, nGlyphIndex );
+
+        olc::Pixel* pAtlas = fontSprite->GetData();
+        for( int y = 0; y < h; y++ )
+            for( int x = 0; x < w; x++ )
+                pAtlas[ size_t( glyph.pos.y + y ) * fontSprite->width + glyph.pos.x + x ] = olc::Pixel( 255, 255, 255, vBitmap[ size_t( y ) * w + x ] );
+
+        glyphs.Add( glyph );
+        vShelves[ vShelfOfRow[glyph.pos.y] ].vCodepoints.push_back( nCodepoint );
+        stats.nRasterised++;
+        stats.nGlyphs = glyphs.Count();
+        bDirty = true;
+        return true;
+    }
+
+
+    bool DynamicFont::Allocate(const olc::vi2d& size, olc::vi2d& pos)
+    {
+        // Leave a pixel between glyphs so filtering never picks up a neighbour
+        const olc::vi2d cell = size + olc::vi2d( 1, 1 );
+        if( cell.x > fontSprite->width || cell.y > fontSprite->height )
+            return false;
+
+        // Best fitting shelf with room left
+        Shelf* best = nullptr;
+        for( auto& shelf : vShelves )
+            if( shelf.height >= cell.y && shelf.x + cell.x <= fontSprite->width && ( best == nullptr || shelf.height < best->height ) )
+                best = &shelf;
+
+        // Otherwise open a new shelf below the others
+        if( best == nullptr && nNextShelfY + cell.y <= fontSprite->height )
+        {
+            Shelf shelf;
+            shelf.y = nNextShelfY;
+            shelf.height = cell.y;
+            std::fill( vShelfOfRow.begin() + shelf.y, vShelfOfRow.begin() + shelf.y + shelf.height, uint16_t( vShelves.size() ) );
+            nNextShelfY += cell.y;
+            vShelves.push_back( shelf );
+            best = &vShelves.back();
+        }
+
+        // Otherwise empty the least recently used shelf that is tall enough and not in use this frame
+        if( best == nullptr )
+        {
+            for( auto& shelf : vShelves )
+                if( shelf.height >= cell.y && shelf.nLastUsed < nFrame && ( best == nullptr || shelf.nLastUsed < best->nLastUsed ) )
+                    best = &shelf;
+
+            if( best == nullptr )
+                return false;
+
+            for( auto c : best->vCodepoints )
+                glyphs.Remove( c );
+            stats.nEvictedGlyphs += best->vCodepoints.size();
+            stats.nEvictedShelves++;
+            best->vCodepoints.clear();
+            best->x = 0;
+        }
+
+        pos = { best->x, best->y };
+        best->x += cell.x;
+        best->nLastUsed = nFrame;
+        return true;
+    }
+
+
+    olc::vi2d DynamicFont::GetTextSize(std::string_view s)
+    {
+        olc::vi2d size = { 0,1 };
+        olc::vi2d pos = { 0,1 };
+        olc::font::DecodeUtf8( s, vCodepoints );
+        for( auto c : vCodepoints )
+        {
+            if (c == '\n') { pos.y++;  pos.x = 0; }
+            else pos.x++;
+            size.x = std::max(size.x, pos.x);
+            size.y = std::max(size.y, pos.y);
+        }
+        return size * vf2d( fCharWidth, fCharHeight );
+    }
+
+
+    olc::vi2d DynamicFont::GetTextSizeProp(std::string_view s)
+    {
+        olc::vi2d size = { 0,1 };
+        olc::vi2d pos = { 0,1 };
+        olc::font::DecodeUtf8( s, vCodepoints );
+        for( auto c : vCodepoints )
+        {
+            if (c == '\n') { pos.y += 1 ;  pos.x = 0; }
+            else pos.x += Fetch( c ).advance;
+            size.x = std::max(size.x, pos.x);
+            size.y = std::max(size.y, pos.y);
+        }
+
+        size.y *= (int)fCharHeight;
+        return size;
+    }
+
+
+    void DynamicFont::LayoutText(std::string_view sText, bool bProportional)
+    {
+        // Layouts of a dynamic font refer to atlas cells that can be reused once a frame has passed,
+        // so they are only ever built for immediate use
+        scratchLayout.Clear();
+        scratchLayout.bProportional = bProportional;
+        scratchLayout.vLineStarts.push_back( 0 );
+
+        olc::vf2d spos = { 0.0f, 0.0f };
+        float fWidth = 0.0f;
+        olc::font::DecodeUtf8( sText, vCodepoints );
+        for( auto c : vCodepoints )
+        {
+            if (c == '\n')
+            {
+                spos.x = 0; spos.y += fCharHeight;
+                scratchLayout.vLineStarts.push_back( scratchLayout.vGlyphs.size() );
+            }
+            else
+            {
+                // Blank glyphs only move the pen
+                auto glyph = Fetch( c );
+                if( glyph.size.y > 0 )
+                    scratchLayout.vGlyphs.push_back( { spos + olc::vf2d( glyph.offset ), glyph.pos, glyph.size } );
+                spos.x += bProportional ? float(glyph.advance) : fCharWidth;
+                fWidth = std::max( fWidth, spos.x );
+            }
+        }
+
+        scratchLayout.size = { int(fWidth), int(scratchLayout.vLineStarts.size()) * int(fCharHeight) };
+    }
+
+
+    void DynamicFont::DrawStringDecal(const olc::vf2d& pos, std::string_view sText, const Pixel col, const olc::vf2d& scale)
+    {
+        LayoutText( sText, false );
+        olc::font::BatchLayout( batch, &fontDecal, pos, scratchLayout, col, scale );
+        if( !bBatching )
+            batch.Submit( pge, fontDecal.get() );
+    }
+
+
+    void DynamicFont::DrawRotatedStringDecal(const olc::vf2d& pos, std::string_view sText, const float fAngle, const olc::vf2d& center, const Pixel col, const olc::vf2d& scale )
+    {
+        LayoutText( sText, false );
+        olc::font::BatchRotatedLayout( batch, &fontDecal, pos, scratchLayout, fAngle, center, col, scale );
+        if( !bBatching )
+            batch.Submit( pge, fontDecal.get() );
+    }
+
+
+    void DynamicFont::DrawStringPropDecal(const olc::vf2d& pos, std::string_view sText, const Pixel col, const olc::vf2d& scale)
+    {
+        LayoutText( sText, true );
+        olc::font::BatchLayout( batch, &fontDecal, pos, scratchLayout, col, scale );
+        if( !bBatching )
+            batch.Submit( pge, fontDecal.get() );
+    }
+
+
+    void DynamicFont::DrawRotatedStringPropDecal(const olc::vf2d& pos, std::string_view sText, const float fAngle, const olc::vf2d& center, const Pixel col, const olc::vf2d& scale )
+    {
+        LayoutText( sText, true );
+        olc::font::BatchRotatedLayout( batch, &fontDecal, pos, scratchLayout, fAngle, center, col, scale );
+        if( !bBatching )
+            batch.Submit( pge, fontDecal.get() );
+    }
+
+
+    void DynamicFont::BeginBatch()
+    {
+        bBatching = true;
+    }
+
+
+    void DynamicFont::EndBatch()
+    {
+        bBatching = false;
+        batch.Submit( pge, fontDecal.get() );
+    }
+
+
+    void DynamicFont::DrawString(olc::Sprite* target, const olc::vi2d& pos, std::string_view sText, const Pixel col, const uint32_t scale)
+    {
+        LayoutText( sText, false );
+        olc::font::RasterLayout( target, &fontSprite, 1, pos, scratchLayout, col, scale );
+    }
+
+
+    void DynamicFont::DrawStringProp(olc::Sprite* target, const olc::vi2d& pos, std::string_view sText, const Pixel col, const uint32_t scale)
+    {
+        LayoutText( sText, true );
+        olc::font::RasterLayout( target, &fontSprite, 1, pos, scratchLayout, col, scale );
+    }
+
+
+    void DynamicFont::SetReplacementGlyph(uint32_t nCodepoint)
+    {
+        nReplacement = nCodepoint;
+    }
+
+
+    void DynamicFont::Flush()
+    {
+        if( !bDirty )
+            return;
+
+        // The engine can only upload whole textures, so everything rasterised during a frame
+        // goes up in one go
+        fontDecal->Update();
+        bDirty = false;
+        stats.nUploads++;
+    }
+
+
+    const DynamicFont::Stats& DynamicFont::GetStats() const
+    {
+        return stats;
+    }
+
+
+    void DynamicFont::OnAfterUserUpdate(float)
+    {
+        Flush();
+        nFrame++;
+    }
+}
+
+#endif
+#endif
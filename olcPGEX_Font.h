@@ -6,34 +6,62 @@
 #include <vector>
 #include <memory>
 #include "olcPixelGameEngine.h"
+#include "olcPGEX_FontCommon.h"
+#include "olcPGEX_BasicFont.h"
 
 namespace olc
 {
-	class Font : public olc::PGEX
-	{
-	public:
-        Font() = delete;
-	    Font(const std::string& sFontFile, olc::ResourcePack* pack = nullptr);
-		
-		olc::vi2d GetTextSize(const std::string& s);
-		olc::vi2d GetTextSizeProp(const std::string& s);
-        
-        void DrawStringDecal(const olc::vf2d& pos, const std::string& sText, const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
-		void DrawRotatedStringDecal(const olc::vf2d& pos, const std::string& sText, const float fAngle, const olc::vf2d& center = {0.0f, 0.0f},  
-                                    const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
-		void DrawStringPropDecal(const olc::vf2d& pos, const std::string& sText, const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
-		void DrawRotatedStringPropDecal(const olc::vf2d& pos, const std::string& sText, const float fAngle, const olc::vf2d& center = {0.0f, 0.0f},  
-                                        const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
-
-    private:
-        std::unique_ptr<olc::Sprite>    fontSprite;
-        std::unique_ptr<olc::Decal>     fontDecal;
-
-        float                           fCharWidth;
-        float                           fCharHeight;
-        std::vector<std::pair<olc::vi2d, olc::vi2d> > vGlyphPositionsMono;
-        std::vector<std::pair<olc::vi2d, olc::vi2d> > vGlyphPositionsProp;
-    };
+    namespace font
+    {
+        // Glyph lookup of olc::Font: the 96 printable ascii characters of a font made by
+        // generatefont.py (or any png of 16x6 evenly spaced characters), indexed directly by
+        // the character. Every other byte finds the replacement glyph, blank unless
+        // SetReplacement() picks one.
+        class AsciiGlyphs
+        {
+        public:
+            void Load(const std::string& sFontFile, olc::ResourcePack* pack, std::vector<std::unique_ptr<olc::Sprite>>& vPages, olc::vi2d& vCharSize, bool& bCoverage);
+
+            template<bool bProportional>
+            const Glyph& Find( uint32_t c ) const
+            {
+                return ( bProportional ? vProp : vMono )[ std::min( c, REPLACEMENT ) ];
+            }
+
+            bool Contains( uint32_t c ) const { return c >= 32 && c < 128; }
+
+            void Coverage( CoverageSet& set ) const
+            {
+                for( uint32_t c = 32; c < 128; c++ )
+                    set.Add( c );
+            }
+
+            bool SetReplacement( uint32_t c )
+            {
+                if( !Contains( c ) )
+                    return false;
+                for( uint32_t i = 0; i <= REPLACEMENT; i++ )
+                {
+                    if( !Contains( i ) )
+                    {
+                        vMono[i] = vMono[c];
+                        vProp[i] = vProp[c];
+                    }
+                }
+                return true;
+            }
+
+        private:
+            static constexpr uint32_t REPLACEMENT = 256;    // slot of the characters above 255
+
+            // Monospaced glyphs are drawn from the whole cell, proportional ones only as wide as they advance
+            std::vector<Glyph> vMono = std::vector<Glyph>( REPLACEMENT + 1 );
+            std::vector<Glyph> vProp = std::vector<Glyph>( REPLACEMENT + 1 );
+        };
+    }
+
+    typedef BasicFont<olc::font::AsciiGlyphs, olc::font::ByteDecoder> Font;
+    extern template class BasicFont<olc::font::AsciiGlyphs, olc::font::ByteDecoder>;
 }
 
 
@@ -42,30 +70,68 @@ namespace olc
 
 namespace olc
 {
-	Font::Font(const std::string& sFontFile, olc::ResourcePack* pack)
-	{
-        fontSprite = std::make_unique<olc::Sprite>( sFontFile, pack );
-        fontDecal = std::make_unique<olc::Decal>( fontSprite.get() );
+    template class BasicFont<olc::font::AsciiGlyphs, olc::font::ByteDecoder>;
+
 
-        // Get the font information embedded in the last row of pixels
+    void font::AsciiGlyphs::Load(const std::string& sFontFile, olc::ResourcePack* pack, std::vector<std::unique_ptr<olc::Sprite>>& vPages, olc::vi2d& vCharSize, bool& bCoverage)
+    {
+        vPages.push_back( std::make_unique<olc::Sprite>( sFontFile, pack ) );
+        olc::Sprite* fontSprite = vPages[0].get();
+
+        auto setGlyph = [&]( uint32_t c, const olc::vi2d& pos, const olc::vi2d& monoSize, const olc::vi2d& propSize )
+        {
+            vMono[c] = { pos, monoSize, monoSize.x, c, 0, {0,0} };
+            vProp[c] = { pos, propSize, propSize.x, c, 0, {0,0} };
+        };
+
+        // Prefer the metrics file written alongside the png, it is read in one go
+        std::vector<uint32_t> vMetricsData;
+        olc::font::MetricsView metrics;
+        if( olc::font::LoadMetrics( sFontFile, pack, vMetricsData, metrics ) )
+        {
+            const bool bGrid = ( metrics.Header().nFlags & olc::font::ATLAS_GRID ) != 0;
+            const olc::vi2d monoCell = { int(metrics.Header().nCharWidth), int(metrics.Header().nCharHeight) - 1 };
+            for( const auto& g : metrics )
+            {
+                // The ascii generator always fits its 96 glyphs on one page
+                if( !Contains( g.nCodepoint ) || g.nPage != 0 )
+                    continue;
+                // Glyphs may be packed tightly, so unless they sit in a grid only the glyph's own
+                // rectangle is drawn and the rest of the fixed width cell is left empty
+                setGlyph( g.nCodepoint, {g.x, g.y}, bGrid ? monoCell : olc::vi2d{g.w, g.h}, {g.nAdvance, g.h} );
+            }
+
+            vCharSize = { int(metrics.Header().nCharWidth), int(metrics.Header().nCharHeight) };
+            bCoverage = ( metrics.Header().nFlags & olc::font::ATLAS_COVERAGE ) != 0;
+            return;
+        }
+
+        // Otherwise get the font information embedded in the last row of pixels
         auto lastRow = fontSprite->height - 1;
         auto pixelValue = fontSprite->GetPixel( 0, lastRow );
         int nCharWidth = fontSprite->width / 16;
         int nCharHeight = (fontSprite->height-1) / 6;
-        
+
         if( pixelValue == olc::Pixel('F','O','N','T') )
         {
             // FONT signature found - presume the pixels contain valid font information
             uint32_t nFormatVersion = fontSprite->GetPixel( 1, lastRow ).n;
             int nOffset             = fontSprite->GetPixel( 2, lastRow ).n;
-           
+
+            if( nFormatVersion > 1 )
+            {
+                // Packed fonts keep their glyph rectangles in the .olcfont file only
+                printf( "%s needs its metrics file %s\n", sFontFile.c_str(), olc::font::MetricsFileName( sFontFile ).c_str() );
+                vCharSize = { nCharWidth, nCharHeight };
+                return;
+            }
+
             for( auto i=0; i < 96; i++ )
             {
                 int nWidth  = fontSprite->GetPixel( 3+i, lastRow ).n;
                 int x       = i % 16 * nCharWidth + nOffset;
                 int y       = i / 16 * nCharHeight;
-                vGlyphPositionsMono.push_back( std::make_pair<olc::vi2d, olc::vi2d>( {x,y}, {nCharWidth, nCharHeight-1}) );
-                vGlyphPositionsProp.push_back( std::make_pair<olc::vi2d, olc::vi2d>( {x,y}, {nWidth, nCharHeight-1}) );
+                setGlyph( 32+i, {x,y}, {nCharWidth, nCharHeight-1}, {nWidth, nCharHeight-1} );
             }
         }
         else
@@ -77,122 +143,11 @@ namespace olc
             {
                 int x = i % 16 * nCharWidth;
                 int y = i / 16 * nCharHeight;
-                vGlyphPositionsMono.push_back( std::make_pair<olc::vi2d, olc::vi2d>( {x,y}, {nCharWidth, nCharHeight-1}) );
-                vGlyphPositionsProp.push_back( std::make_pair<olc::vi2d, olc::vi2d>( {x,y}, {nCharWidth, nCharHeight-1}) );
+                setGlyph( 32+i, {x,y}, {nCharWidth, nCharHeight-1}, {nCharWidth, nCharHeight-1} );
             }
         }
 
-        fCharWidth  = float(nCharWidth);
-        fCharHeight = float(nCharHeight);
-    }
-
-
-    olc::vi2d Font::GetTextSize(const std::string& s)
-	{
-		olc::vi2d size = { 0,1 };
-		olc::vi2d pos = { 0,1 };
-		for (auto c : s)
-		{
-			if (c == '\n') { pos.y++;  pos.x = 0; }
-			else pos.x++;
-			size.x = std::max(size.x, pos.x);
-			size.y = std::max(size.y, pos.y);
-		}
-		return size * vf2d( fCharWidth, fCharHeight );
-	}
-
-
-	olc::vi2d Font::GetTextSizeProp(const std::string& s)
-	{
-		olc::vi2d size = { 0,1 };
-		olc::vi2d pos = { 0,1 };
-		for (auto c : s)
-		{
-			if (c == '\n') { pos.y += 1;  pos.x = 0; }
-			else pos.x += vGlyphPositionsProp[c-32].second.x;
-			size.x = std::max(size.x, pos.x);
-			size.y = std::max(size.y, pos.y);
-		}
-
-		size.y *= (int)fCharHeight;
-		return size;
-	}
-
-
-	void Font::DrawStringDecal(const olc::vf2d& pos, const std::string& sText, const Pixel col, const olc::vf2d& scale)
-	{
-		olc::vf2d spos = { 0.0f, 0.0f };
-		for (auto c : sText)
-		{
-			if (c == '\n')
-			{
-				spos.x = 0; spos.y += fCharHeight * scale.y;
-			}
-			else
-			{
-                auto& glyph = vGlyphPositionsMono[c-32];
-				pge->DrawPartialDecal(pos + spos, fontDecal.get(), glyph.first, glyph.second, scale, col);
-				spos.x += fCharWidth * scale.x;
-			}
-		}
-	}
-
-
-	void Font::DrawRotatedStringDecal(const olc::vf2d& pos, const std::string& sText, const float fAngle, const olc::vf2d& center, const Pixel col, const olc::vf2d& scale )
-    {
-		olc::vf2d spos = center;
-		for (auto c : sText)
-		{
-			if (c == '\n')
-			{
-				spos.x = center.x; spos.y -= fCharHeight;
-			}
-			else
-			{
-                auto& glyph = vGlyphPositionsMono[c-32];
-				pge->DrawPartialRotatedDecal(pos, fontDecal.get(), fAngle, spos, glyph.first, glyph.second, scale, col);
-				spos.x -= fCharWidth;
-			}
-		}
-    }
-
-
-	void Font::DrawStringPropDecal(const olc::vf2d& pos, const std::string& sText, const Pixel col, const olc::vf2d& scale)
-	{
-		olc::vf2d spos = { 0.0f, 0.0f };
-		for (auto c : sText)
-		{
-			if (c == '\n')
-			{
-				spos.x = 0; spos.y += fCharHeight * scale.y;
-			}
-			else
-			{
-                auto& glyph = vGlyphPositionsProp[c-32];
-				pge->DrawPartialDecal(pos + spos, fontDecal.get(), glyph.first, glyph.second, scale, col);
-				spos.x += glyph.second.x * scale.x;
-			}
-		}
-	}
-
-
-	void Font::DrawRotatedStringPropDecal(const olc::vf2d& pos, const std::string& sText, const float fAngle, const olc::vf2d& center, const Pixel col, const olc::vf2d& scale )
-    {
-		olc::vf2d spos = center;
-
-		for (auto c : sText)
-		{
-			if (c == '\n')
-			{
-				spos.x = center.x; spos.y -= fCharHeight;
-			}
-			else
-			{
-                auto& glyph = vGlyphPositionsProp[c-32];
-				pge->DrawPartialRotatedDecal(pos, fontDecal.get(), fAngle, spos, glyph.first, glyph.second, scale, col);
-				spos.x -= glyph.second.x;
-			}
-		}
+        vCharSize = { nCharWidth, nCharHeight };
     }
 }
 
@@ -0,0 +1,272 @@
+#pragma once
+
+#ifndef __OLC_PGEX_FONTCHAIN__
+#define __OLC_PGEX_FONTCHAIN__
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <functional>
+#include "olcPixelGameEngine.h"
+#include "olcPGEX_FontCommon.h"
+
+namespace olc
+{
+    // Draws utf-8 text with several fonts - latin, CJK, symbols - each character with the first
+    // font of the chain that has a glyph for it:
+    //
+    //     // OnUserCreate
+    //     chain.Add( *latin );     // olc::Font or olc::CustomFont
+    //     chain.Add( *cjk );
+    //     chain.Add( *symbols );
+    //
+    //     // OnUserUpdate
+    //     chain.DrawStringPropDecal( { 10, 10 }, "Score ★ 1200 得点" );
+    //
+    // The font of every codepoint is worked out once, in Add(), from the coverage of the fonts,
+    // so choosing the font of a character is one table lookup however long the chain is.
+    // Characters no font has are drawn by the first font, with its replacement glyph.
+    //
+    // The text is decoded once and split into runs of characters sharing a font. Each font draws
+    // its runs straight from the decoded codepoints, inside a batch of that font, so a string
+    // switches decals once per atlas page used rather than once per run, and the pen moves on by
+    // the advance the font worked out while drawing. Each font keeps its own glyph sizes, and its
+    // runs are moved down so the baselines of the fonts line up; lines are as high as the fonts
+    // need once aligned. The fonts have to outlive the chain.
+    class FontChain
+    {
+    public:
+        FontChain();
+
+        // Appends a font to the chain. Returns false once the chain has 255 fonts.
+        // nBaseline is the row of the font's cell its glyphs stand on, counted from the top; the
+        // png fonts don't record one, so by default it is the bottom of the cell, lining up the
+        // bottoms of the fonts' cells
+        template<class TFont>
+        bool Add(TFont& font, int nBaseline = -1);
+
+        size_t Fonts() const { return vLinks.size(); }
+
+        // Index of the font that draws c
+        size_t Select(uint32_t c) const;
+
+        olc::vi2d GetTextSize(std::string_view sText);
+        olc::vi2d GetTextSizeProp(std::string_view sText);
+
+        void DrawStringDecal(const olc::vf2d& pos, std::string_view sText, const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
+        void DrawStringPropDecal(const olc::vf2d& pos, std::string_view sText, const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
+
+        // Batches every font of the chain until EndBatch(), see BasicFont::BeginBatch()
+        void BeginBatch();
+        void EndBatch();
+
+    private:
+        // What is needed of each font, whatever its type
+        // Runs are passed as spans of codepoints, and both functions return the pen advance
+        struct Link
+        {
+            std::function<float(const uint32_t*, const uint32_t*, bool bProportional)>                                                 advance;
+            std::function<float(const olc::vf2d&, const uint32_t*, const uint32_t*, bool bProportional, const Pixel, const olc::vf2d&)> draw;
+            std::function<void(bool bBegin)>                                                                                            batch;
+            int nHeight = 0;        // of the font's lines
+            int nBaseline = 0;      // from the top of the font's line
+            int nOffset = 0;        // the font's runs are drawn this far below the top of the chain's line
+        };
+
+        void Assign(const olc::font::CoverageSet& coverage);
+        void AlignBaselines();
+        olc::vi2d Walk(std::string_view sText, bool bProportional, bool bDraw, const olc::vf2d& pos, const Pixel col, const olc::vf2d& scale);
+
+    private:
+        static constexpr uint32_t PAGE_BITS  = 8;
+        static constexpr uint32_t PAGE_SIZE  = 1 << PAGE_BITS;
+        static constexpr uint32_t PAGE_COUNT = 0x110000 >> PAGE_BITS;
+
+        std::vector<Link>           vLinks;
+        std::vector<uint16_t>       vPageIndex;     // page of each 256 codepoint block, 0 is the shared empty page
+        std::vector<uint8_t>        vPages;         // font + 1 of each codepoint, 0 if none has it, PAGE_SIZE entries per page
+        int                         nLineHeight = 0;
+        bool                        bBatching = false;
+
+        std::vector<uint32_t>       vBuffer;
+    };
+
+
+    template<class TFont>
+    bool FontChain::Add(TFont& font, int nBaseline)
+    {
+        if( vLinks.size() >= 255 )
+            return false;
+
+        Link link;
+        link.advance = [&font]( const uint32_t* pBegin, const uint32_t* pEnd, bool bProportional )
+        {
+            return font.GetCodepointsAdvance( pBegin, pEnd, bProportional );
+        };
+        link.draw = [&font]( const olc::vf2d& pos, const uint32_t* pBegin, const uint32_t* pEnd, bool bProportional, const Pixel col, const olc::vf2d& scale )
+        {
+            return font.DrawCodepointsDecal( pos, pBegin, pEnd, bProportional, col, scale );
+        };
+        link.batch = [&font]( bool bBegin ) { if( bBegin ) font.BeginBatch(); else font.EndBatch(); };
+        link.nHeight = font.GetTextSize( "" ).y;
+        link.nBaseline = nBaseline < 0 ? link.nHeight : nBaseline;
+        vLinks.push_back( std::move( link ) );
+
+        AlignBaselines();
+        Assign( font.Coverage() );
+
+        // Join a batch that is already open
+        if( bBatching )
+            vLinks.back().batch( true );
+        return true;
+    }
+}
+
+
+#ifdef OLC_PGEX_FONTCHAIN
+#undef OLC_PGEX_FONTCHAIN
+
+namespace olc
+{
+    FontChain::FontChain()
+    {
+        vPageIndex.assign( PAGE_COUNT, 0 );
+        vPages.assign( PAGE_SIZE, 0 );
+    }
+
+
+    void FontChain::Assign(const olc::font::CoverageSet& coverage)
+    {
+        // The new font only takes the codepoints no earlier font has
+        const uint8_t nEntry = uint8_t( vLinks.size() );
+        coverage.ForEach( [&]( uint32_t c )
+        {
+            uint16_t& nPage = vPageIndex[c >> PAGE_BITS];
+            if( nPage == 0 )
+            {
+                nPage = uint16_t( vPages.size() / PAGE_SIZE );
+                vPages.resize( vPages.size() + PAGE_SIZE, 0 );
+            }
+            uint8_t& nFont = vPages[ ( size_t( nPage ) << PAGE_BITS ) | ( c & ( PAGE_SIZE - 1 ) ) ];
+            if( nFont == 0 )
+                nFont = nEntry;
+        } );
+    }
+
+
+    void FontChain::AlignBaselines()
+    {
+        // The line's baseline sits as low as the font reaching highest above its baseline needs
+        int nLineBaseline = 0;
+        for( auto& link : vLinks )
+            nLineBaseline = std::max( nLineBaseline, link.nBaseline );
+
+        nLineHeight = 0;
+        for( auto& link : vLinks )
+        {
+            link.nOffset = nLineBaseline - link.nBaseline;
+            nLineHeight = std::max( nLineHeight, link.nOffset + link.nHeight );
+        }
+    }
+
+
+    size_t FontChain::Select(uint32_t c) const
+    {
+        if( ( c >> PAGE_BITS ) >= PAGE_COUNT )
+            return 0;
+        uint8_t nEntry = vPages[ ( size_t( vPageIndex[c >> PAGE_BITS] ) << PAGE_BITS ) | ( c & ( PAGE_SIZE - 1 ) ) ];
+        return nEntry == 0 ? 0 : nEntry - 1;
+    }
+
+
+    olc::vi2d FontChain::GetTextSize(std::string_view sText)
+    {
+        return Walk( sText, false, false, { 0.0f, 0.0f }, olc::WHITE, { 1.0f, 1.0f } );
+    }
+
+
+    olc::vi2d FontChain::GetTextSizeProp(std::string_view sText)
+    {
+        return Walk( sText, true, false, { 0.0f, 0.0f }, olc::WHITE, { 1.0f, 1.0f } );
+    }
+
+
+    void FontChain::DrawStringDecal(const olc::vf2d& pos, std::string_view sText, const Pixel col, const olc::vf2d& scale)
+    {
+        Walk( sText, false, true, pos, col, scale );
+    }
+
+
+    void FontChain::DrawStringPropDecal(const olc::vf2d& pos, std::string_view sText, const Pixel col, const olc::vf2d& scale)
+    {
+        Walk( sText, true, true, pos, col, scale );
+    }
+
+
+    void FontChain::BeginBatch()
+    {
+        if( bBatching )
+            return;
+        bBatching = true;
+        for( auto& link : vLinks )
+            link.batch( true );
+    }
+
+
+    void FontChain::EndBatch()
+    {
+        if( !bBatching )
+            return;
+        bBatching = false;
+        for( auto& link : vLinks )
+            link.batch( false );
+    }
+
+
+    olc::vi2d FontChain::Walk(std::string_view sText, bool bProportional, bool bDraw, const olc::vf2d& pos, const Pixel col, const olc::vf2d& scale)
+    {
+        olc::vi2d size = { 0, nLineHeight };
+        if( vLinks.empty() )
+            return size;
+
+        // Each font collects its runs in its own batch, submitted together at the end
+        const bool bOwnBatch = bDraw && !bBatching;
+        if( bOwnBatch )
+            BeginBatch();
+
+        auto text = olc::font::Utf8Decoder::Decode( sText, vBuffer );
+        float x = 0.0f;
+        int y = 0;
+        for( const uint32_t* p = text.begin(); p != text.end(); )
+        {
+            if( *p == '\n' )
+            {
+                x = 0.0f;
+                y += nLineHeight;
+                size.y = y + nLineHeight;
+                p++;
+                continue;
+            }
+
+            // The run of characters sharing the font of the first
+            const size_t nFont = Select( *p );
+            const uint32_t* pRun = p;
+            for( ; p != text.end() && *p != '\n' && Select( *p ) == nFont; p++ );
+
+            Link& link = vLinks[nFont];
+            if( bDraw )
+                x += link.draw( pos + olc::vf2d( x, float( y + link.nOffset ) ) * scale, pRun, p, bProportional, col, scale );
+            else
+                x += link.advance( pRun, p, bProportional );
+            size.x = std::max( size.x, int( x ) );
+        }
+
+        if( bOwnBatch )
+            EndBatch();
+        return size;
+    }
+}
+
+#endif
+#endif
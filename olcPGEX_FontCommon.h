@@ -0,0 +1,1391 @@
+#pragma once
+
+#ifndef __OLC_PGEX_FONTCOMMON__
+#define __OLC_PGEX_FONTCOMMON__
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <functional>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <type_traits>
+#include <charconv>
+#include <cstdio>
+#include "olcPixelGameEngine.h"
+
+#if defined(__AVX__) || defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+
+// Glyphs are submitted to the engine as triangle lists of at most this many vertices per
+// decal instance. The OpenGL 3.3 renderer of the olcPixelGameEngine holds OLC_MAX_VERTS (128)
+// vertices per instance, raise this if your renderer allows more.
+#ifndef OLC_PGEX_FONT_MAX_BATCH_VERTS
+#define OLC_PGEX_FONT_MAX_BATCH_VERTS 126
+#endif
+
+// Define OLC_PGEX_FONT_STATS before including the font extensions to have every Font and
+// CustomFont count what it looks up, decodes and draws, see olc::font::FontStats. Without
+// it the counting compiles away entirely.
+#ifdef OLC_PGEX_FONT_STATS
+#include <chrono>
+#define OLC_PGEX_FONT_STAT(...) __VA_ARGS__
+#else
+#define OLC_PGEX_FONT_STAT(...)
+#endif
+
+// Types and helpers shared by olc::Font and olc::CustomFont (see olcPGEX_BasicFont.h).
+// Everything in here is inline so the header can be included by both extensions
+// in any number of translation units.
+
+namespace olc
+{
+    // A string that has been decoded, had its glyphs looked up and been positioned once.
+    // Build it with Font::LayoutText() / CustomFont::LayoutText() and hand it back to the
+    // same font's draw functions as often as you like - no further parsing takes place.
+    struct TextLayout
+    {
+        struct Glyph
+        {
+            olc::vf2d   offset;         // pen position relative to the start of the text (unscaled)
+            olc::vi2d   sourcePos;      // top left of the glyph in the font sprite
+            olc::vi2d   sourceSize;     // size of the glyph in the font sprite
+            uint32_t    page = 0;       // atlas page the glyph is on
+        };
+
+        std::vector<Glyph>  vGlyphs;
+        std::vector<size_t> vLineStarts;            // index into vGlyphs of the first glyph of each line
+        olc::vi2d           size = { 0, 0 };        // same as GetTextSize() / GetTextSizeProp() of the source string
+        bool                bProportional = true;
+
+        void Clear()
+        {
+            vGlyphs.clear();
+            vLineStarts.clear();
+            size = { 0, 0 };
+        }
+    };
+
+
+    // One of the strings drawn by DrawLabelsDecal(). The text isn't copied, it only has to
+    // stay alive for the duration of the call.
+    struct TextLabel
+    {
+        olc::vf2d           pos;
+        std::string_view    sText;
+        olc::Pixel          col = olc::WHITE;
+        olc::vf2d           scale = { 1.0f, 1.0f };
+        float               fAngle = 0.0f;              // about pos. Unrotated labels are clipped, rotated ones aren't
+        olc::vf2d           align = { 0.0f, 0.0f };     // the point of the text put at pos, as a fraction of its size - { 0.5f, 0.5f } centres it
+        bool                bProportional = true;
+    };
+
+
+    namespace font
+    {
+        // Decodes the utf-8 sequence starting at s[i] and moves i past it. Anything that isn't
+        // well formed utf-8 - stray continuation bytes, overlong forms, surrogates, values past
+        // U+10FFFF or a sequence cut short by the end of the string - decodes to U+FFFD, consuming
+        // the bytes up to the point the sequence went wrong (at least one). Never reads past s.
+        inline uint32_t DecodeUtf8Codepoint( std::string_view s, size_t& i )
+        {
+            const uint8_t b0 = uint8_t( s[i] );
+            if( b0 < 0x80 ) { i++; return b0; }
+
+            uint32_t c;
+            size_t nLength;
+            uint8_t lo = 0x80, hi = 0xBF;     // allowed range of the second byte
+            if( b0 >= 0xC2 && b0 <= 0xDF )      { nLength = 2; c = b0 & 0x1F; }
+            else if( b0 >= 0xE0 && b0 <= 0xEF ) { nLength = 3; c = b0 & 0x0F; if( b0 == 0xE0 ) lo = 0xA0; else if( b0 == 0xED ) hi = 0x9F; }
+            else if( b0 >= 0xF0 && b0 <= 0xF4 ) { nLength = 4; c = b0 & 0x07; if( b0 == 0xF0 ) lo = 0x90; else if( b0 == 0xF4 ) hi = 0x8F; }
+            else { i++; return 0xFFFD; }
+
+            size_t j = i + 1;
+            for( size_t k = 1; k < nLength; k++, j++ )
+            {
+                if( j >= s.size() || uint8_t( s[j] ) < lo || uint8_t( s[j] ) > hi )
+                {
+                    i = j;
+                    return 0xFFFD;
+                }
+                c = ( c << 6 ) | ( uint8_t( s[j] ) & 0x3F );
+                lo = 0x80; hi = 0xBF;
+            }
+            i = j;
+            return c;
+        }
+
+
+        // Decodes a whole string into vCodepoints (replacing its contents), see DecodeUtf8Codepoint().
+        // Runs of ascii are widened 16 or 32 bytes at a time where the target allows.
+        inline void DecodeUtf8( std::string_view s, std::vector<uint32_t>& vCodepoints )
+        {
+            // Never more codepoints than bytes
+            vCodepoints.resize( s.size() );
+            uint32_t* pOut = vCodepoints.data();
+            const uint8_t* p = reinterpret_cast<const uint8_t*>( s.data() );
+            const size_t n = s.size();
+            size_t i = 0;
+
+            while( i < n )
+            {
+#if defined(__AVX2__)
+                for( ; i + 32 <= n; i += 32, pOut += 32 )
+                {
+                    __m256i v = _mm256_loadu_si256( (const __m256i*)( p + i ) );
+                    if( _mm256_movemask_epi8( v ) != 0 )
+                        break;
+                    for( int k = 0; k < 4; k++ )
+                        _mm256_storeu_si256( (__m256i*)( pOut + k * 8 ), _mm256_cvtepu8_epi32( _mm_loadl_epi64( (const __m128i*)( p + i + k * 8 ) ) ) );
+                }
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+                const __m128i vZero = _mm_setzero_si128();
+                for( ; i + 16 <= n; i += 16, pOut += 16 )
+                {
+                    __m128i v = _mm_loadu_si128( (const __m128i*)( p + i ) );
+                    if( _mm_movemask_epi8( v ) != 0 )
+                        break;
+                    __m128i lo = _mm_unpacklo_epi8( v, vZero ), hi = _mm_unpackhi_epi8( v, vZero );
+                    _mm_storeu_si128( (__m128i*)( pOut +  0 ), _mm_unpacklo_epi16( lo, vZero ) );
+                    _mm_storeu_si128( (__m128i*)( pOut +  4 ), _mm_unpackhi_epi16( lo, vZero ) );
+                    _mm_storeu_si128( (__m128i*)( pOut +  8 ), _mm_unpacklo_epi16( hi, vZero ) );
+                    _mm_storeu_si128( (__m128i*)( pOut + 12 ), _mm_unpackhi_epi16( hi, vZero ) );
+                }
+#endif
+                // The rest of the ascii run a byte at a time, then one multi byte sequence
+                while( i < n && p[i] < 0x80 )
+                    *pOut++ = p[i++];
+                if( i < n )
+                    *pOut++ = DecodeUtf8Codepoint( s, i );
+            }
+
+            vCodepoints.resize( size_t( pOut - vCodepoints.data() ) );
+        }
+
+
+        // The characters of a string as a font's decoder hands them to its draw loops
+        template<class T>
+        struct CharSpan
+        {
+            const T* pBegin = nullptr;
+            const T* pEnd = nullptr;
+
+            const T* begin() const { return pBegin; }
+            const T* end() const { return pEnd; }
+            size_t size() const { return size_t( pEnd - pBegin ); }
+        };
+
+        // Decoder of olc::Font: every byte is a character, so the string is used as it is
+        struct ByteDecoder
+        {
+            using Char = uint8_t;
+            static CharSpan<Char> Decode( std::string_view s, std::vector<uint32_t>& )
+            {
+                const Char* p = reinterpret_cast<const Char*>( s.data() );
+                return { p, p + s.size() };
+            }
+
+            // The reverse, for text held as characters. Anything above a byte is drawn as the replacement glyph
+            static void Encode( uint32_t c, std::string& s )
+            {
+                s += char( c < 256 ? c : 0xFF );
+            }
+        };
+
+        // Decoder of olc::CustomFont: the string is utf-8, decoded into the buffer in one go
+        struct Utf8Decoder
+        {
+            using Char = uint32_t;
+            static CharSpan<Char> Decode( std::string_view s, std::vector<uint32_t>& vBuffer )
+            {
+                DecodeUtf8( s, vBuffer );
+                return { vBuffer.data(), vBuffer.data() + vBuffer.size() };
+            }
+
+            static void Encode( uint32_t c, std::string& s )
+            {
+                if( c > 0x10FFFF ) c = 0xFFFD;
+                if( c < 0x80 ) s += char( c );
+                else if( c < 0x800 ) { s += char( 0xC0 | ( c >> 6 ) ); s += char( 0x80 | ( c & 0x3F ) ); }
+                else if( c < 0x10000 ) { s += char( 0xE0 | ( c >> 12 ) ); s += char( 0x80 | ( ( c >> 6 ) & 0x3F ) ); s += char( 0x80 | ( c & 0x3F ) ); }
+                else { s += char( 0xF0 | ( c >> 18 ) ); s += char( 0x80 | ( ( c >> 12 ) & 0x3F ) ); s += char( 0x80 | ( ( c >> 6 ) & 0x3F ) ); s += char( 0x80 | ( c & 0x3F ) ); }
+            }
+        };
+    }
+
+
+    // Decodes the utf-8 sequence starting at s[i] and moves i past it, see font::DecodeUtf8Codepoint()
+    inline uint32_t _next_utf8_codepoint( const std::string& s, int& i )
+    {
+        size_t j = size_t( i );
+        uint32_t c = olc::font::DecodeUtf8Codepoint( s, j );
+        i = int( j );
+        return c;
+    }
+
+
+    namespace font
+    {
+        // Passed to the Font / CustomFont constructors to load everything except the GPU side of
+        // the font, which CreateDecals() adds later on the main thread. See olc::FontLoader
+        struct DeferDecalsTag {};
+        inline constexpr DeferDecalsTag DeferDecals{};
+
+
+        // Identifies a font object for the caches keyed on fonts, see BasicFont::GetId(). Every font
+        // gets a number no font before it had, so a new font allocated where a destroyed one lived
+        // can't be mistaken for it. Copies get a number of their own too.
+        class FontId
+        {
+        public:
+            FontId() : nId( Next() ) {}
+            FontId(const FontId&) : nId( Next() ) {}
+            FontId& operator=(const FontId&) { return *this; }
+
+            uint64_t Get() const { return nId; }
+
+        private:
+            static uint64_t Next() { static std::atomic<uint64_t> nLast{ 0 }; return ++nLast; }
+            uint64_t nId;
+        };
+
+
+        // A number written with a fixed count of decimals, eg. Fixed( fFrameTime * 1000.0, 2 )
+        struct Fixed
+        {
+            double  fValue;
+            int     nDecimals;
+        };
+
+        // Text put together on the stack from strings and numbers, so readouts like "FPS: 60" can
+        // be drawn every frame without allocating. Numbers are written with std::to_chars,
+        // floating point ones as short as they read back exactly. Text beyond N characters is cut
+        // off. Converts to std::string_view, so it can be passed to any of the draw functions:
+        //
+        //     font->DrawStringDecal( { 4, 4 }, olc::font::FormatBuffer<>( "x ", pos.x, " y ", pos.y ) );
+        template<size_t N = 128>
+        class FormatBuffer
+        {
+        public:
+            FormatBuffer() = default;
+            template<class... Args> explicit FormatBuffer( const Args&... args ) { ( Append( args ), ... ); }
+
+            FormatBuffer& Append( std::string_view s )
+            {
+                size_t n = std::min( s.size(), N - nLength );
+                std::memcpy( data + nLength, s.data(), n );
+                nLength += n;
+                return *this;
+            }
+
+            FormatBuffer& Append( const char* s ) { return Append( std::string_view( s ) ); }
+            FormatBuffer& Append( char c ) { return Append( std::string_view( &c, 1 ) ); }
+            FormatBuffer& Append( bool b ) { return Append( b ? std::string_view( "true" ) : std::string_view( "false" ) ); }
+
+            template<class T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, char> && !std::is_same_v<T, bool>, int> = 0>
+            FormatBuffer& Append( T value )
+            {
+                char digits[64];
+                char* pEnd = digits;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+                pEnd = std::to_chars( digits, digits + sizeof( digits ), value ).ptr;
+#else
+                // Standard libraries without floating point to_chars
+                if constexpr( std::is_integral_v<T> )
+                    pEnd = std::to_chars( digits, digits + sizeof( digits ), value ).ptr;
+                else
+                    pEnd = digits + std::max( std::snprintf( digits, sizeof( digits ), "%.17g", double( value ) ), 0 );
+#endif
+                return Append( std::string_view( digits, size_t( pEnd - digits ) ) );
+            }
+
+            FormatBuffer& Append( Fixed f )
+            {
+                char digits[64];
+                int nDecimals = std::clamp( f.nDecimals, 0, 17 );
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+                auto result = std::to_chars( digits, digits + sizeof( digits ), f.fValue, std::chars_format::fixed, nDecimals );
+                // Too large to write out in full
+                if( result.ec != std::errc() )
+                    return Append( f.fValue );
+                return Append( std::string_view( digits, size_t( result.ptr - digits ) ) );
+#else
+                int n = std::snprintf( digits, sizeof( digits ), "%.*f", nDecimals, f.fValue );
+                if( n < 0 || n >= int( sizeof( digits ) ) )
+                    return Append( f.fValue );
+                return Append( std::string_view( digits, size_t( n ) ) );
+#endif
+            }
+
+            void Clear() { nLength = 0; }
+            std::string_view View() const { return { data, nLength }; }
+            operator std::string_view() const { return View(); }
+
+        private:
+            char    data[N];
+            size_t  nLength = 0;
+        };
+
+
+#ifdef OLC_PGEX_FONT_STATS
+        // What one font has been doing. Read it with GetStats() of the font, or have every font's
+        // stats handed to a profiler once a frame with SetStatsHook() and EndStatsFrame().
+        struct FontStats
+        {
+            struct Counters
+            {
+                uint64_t    nDecoded    = 0;    // characters read from strings (codepoints for CustomFont)
+                uint64_t    nLookups    = 0;    // characters looked up in the glyph table
+                uint64_t    nMisses     = 0;    // lookups of characters the font has no glyph for
+                uint64_t    nGlyphs     = 0;    // glyphs drawn, as decals or into sprites
+                uint64_t    nInstances  = 0;    // decal instances submitted to the engine
+            };
+
+            std::string sName;                  // the font's png
+            Counters    frame;                  // since the last EndStatsFrame()
+            Counters    total;                  // since the font was loaded
+            size_t      nAtlasBytes   = 0;      // atlas sprites kept in memory
+            size_t      nTextureBytes = 0;      // textures of the atlas decals
+            double      fLoadSeconds  = 0.0;    // spent in the constructor reading the png(s) and metrics
+
+            FontStats() = default;
+            FontStats( const FontStats& ) = default;
+            FontStats& operator=( const FontStats& ) = default;
+            ~FontStats();
+
+            void Decoded( size_t n )                    { frame.nDecoded += n; total.nDecoded += n; }
+            void Lookup( bool bFound )                  { frame.nLookups++; total.nLookups++; frame.nMisses += !bFound; total.nMisses += !bFound; }
+            void Drawn( size_t nGlyphs, size_t nInstances )
+            {
+                frame.nGlyphs += nGlyphs; total.nGlyphs += nGlyphs;
+                frame.nInstances += nInstances; total.nInstances += nInstances;
+            }
+
+            // Adds counts made elsewhere, eg. on a worker thread
+            void Add( const Counters& c )
+            {
+                for( Counters* p : { &frame, &total } )
+                {
+                    p->nDecoded += c.nDecoded; p->nLookups += c.nLookups; p->nMisses += c.nMisses;
+                    p->nGlyphs += c.nGlyphs; p->nInstances += c.nInstances;
+                }
+            }
+        };
+
+
+        // The fonts taking part in EndStatsFrame(), and the hook it reports to
+        struct StatsRegistry
+        {
+            std::mutex                                  mux;
+            std::vector<FontStats*>                     vStats;
+            std::function<void(const FontStats&)>       hook;
+
+            static StatsRegistry& Get() { static StatsRegistry registry; return registry; }
+        };
+
+        // Fonts add themselves once their decals are created
+        inline void RegisterStats( FontStats* stats )
+        {
+            auto& registry = StatsRegistry::Get();
+            std::unique_lock<std::mutex> lock( registry.mux );
+            if( std::find( registry.vStats.begin(), registry.vStats.end(), stats ) == registry.vStats.end() )
+                registry.vStats.push_back( stats );
+        }
+
+        inline FontStats::~FontStats()
+        {
+            auto& registry = StatsRegistry::Get();
+            std::unique_lock<std::mutex> lock( registry.mux );
+            registry.vStats.erase( std::remove( registry.vStats.begin(), registry.vStats.end(), this ), registry.vStats.end() );
+        }
+
+        // Called by EndStatsFrame() with the stats of each font, before its frame counters are reset
+        inline void SetStatsHook( std::function<void(const FontStats&)> hook )
+        {
+            auto& registry = StatsRegistry::Get();
+            std::unique_lock<std::mutex> lock( registry.mux );
+            registry.hook = std::move( hook );
+        }
+
+        // Call once a frame, eg. at the end of OnUserUpdate(): reports every font's stats to the
+        // hook and starts counting the next frame. Main thread only, like the drawing itself.
+        inline void EndStatsFrame()
+        {
+            auto& registry = StatsRegistry::Get();
+            std::vector<FontStats*> vStats;
+            std::function<void(const FontStats&)> hook;
+            {
+                std::unique_lock<std::mutex> lock( registry.mux );
+                vStats = registry.vStats;
+                hook = registry.hook;
+            }
+
+            for( auto stats : vStats )
+            {
+                if( hook )
+                    hook( *stats );
+                stats->frame = FontStats::Counters();
+            }
+        }
+
+        // Stores the time until the end of the scope in fSeconds
+        struct ScopeTimer
+        {
+            double& fSeconds;
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            ~ScopeTimer() { fSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count(); }
+        };
+#endif
+
+
+        // Everything the draw and measure functions need to know about one glyph
+        struct Glyph
+        {
+            olc::vi2d   pos;                // top left of the glyph in the font sprite
+            olc::vi2d   size;               // proportional size of the glyph in the font sprite
+            int32_t     advance = 0;        // proportional pen advance
+            uint32_t    codepoint = 0;
+            uint32_t    page = 0;           // atlas page the glyph is on
+            olc::vi2d   offset;             // top left of the glyph relative to the pen, for glyphs cut to their ink (DynamicFont)
+        };
+
+
+        // The codepoints a font has glyphs for, one bit each, in blocks of 256 codepoints. Blocks
+        // without any glyph share one empty block, so Contains() is two loads and a shift
+        // whichever codepoint is asked about and however many glyphs the font has.
+        class CoverageSet
+        {
+        public:
+            CoverageSet() { Clear(); }
+
+            void Clear()
+            {
+                vBlockIndex.assign( BLOCK_COUNT, 0 );
+                vBits.assign( BLOCK_WORDS, 0 );
+                nCount = 0;
+            }
+
+            void Add( uint32_t c )
+            {
+                uint32_t nBlock = c >> BLOCK_BITS;
+                if( nBlock >= BLOCK_COUNT )
+                    return;
+
+                if( vBlockIndex[nBlock] == 0 )
+                {
+                    vBlockIndex[nBlock] = uint16_t( vBits.size() / BLOCK_WORDS );
+                    vBits.resize( vBits.size() + BLOCK_WORDS, 0 );
+                }
+
+                uint64_t& nWord = vBits[ Word( c ) ];
+                uint64_t nBit = uint64_t( 1 ) << ( c & 63 );
+                nCount += ( nWord & nBit ) == 0;
+                nWord |= nBit;
+            }
+
+            bool Contains( uint32_t c ) const
+            {
+                return (c >> BLOCK_BITS) < BLOCK_COUNT && ( vBits[ Word( c ) ] >> ( c & 63 ) & 1 ) != 0;
+            }
+
+            size_t Count() const { return nCount; }
+
+            // Calls f( c ) for every codepoint in the set, in order
+            template<class F>
+            void ForEach( F&& f ) const
+            {
+                for( uint32_t nBlock = 0; nBlock < BLOCK_COUNT; nBlock++ )
+                {
+                    if( vBlockIndex[nBlock] == 0 )
+                        continue;
+                    for( uint32_t w = 0; w < BLOCK_WORDS; w++ )
+                    {
+                        for( uint64_t nBits = vBits[ size_t( vBlockIndex[nBlock] ) * BLOCK_WORDS + w ]; nBits != 0; nBits &= nBits - 1 )
+                        {
+                            uint32_t nBit = 0;
+                            while( ( nBits >> nBit & 1 ) == 0 )
+                                nBit++;
+                            f( ( nBlock << BLOCK_BITS ) | ( w * 64 + nBit ) );
+                        }
+                    }
+                }
+            }
+
+        private:
+            static constexpr uint32_t BLOCK_BITS  = 8;
+            static constexpr uint32_t BLOCK_WORDS = ( 1 << BLOCK_BITS ) / 64;
+            static constexpr uint32_t BLOCK_COUNT = 0x110000 >> BLOCK_BITS;
+
+            size_t Word( uint32_t c ) const
+            {
+                return size_t( vBlockIndex[c >> BLOCK_BITS] ) * BLOCK_WORDS + ( ( c >> 6 ) & ( BLOCK_WORDS - 1 ) );
+            }
+
+            std::vector<uint16_t>   vBlockIndex;    // block of each 256 codepoints, 0 is the shared empty block
+            std::vector<uint64_t>   vBits;          // BLOCK_WORDS words per block
+            size_t                  nCount = 0;
+        };
+
+
+        // Codepoint -> glyph lookup built once at load time. A two level page table over the
+        // unicode range maps each codepoint to an index into a packed array of glyph records.
+        // Codepoints without a glyph resolve to slot 0, the replacement glyph, so a miss costs
+        // the same as a hit and nothing is ever written while drawing.
+        class GlyphTable
+        {
+        public:
+            GlyphTable() { Clear(); }
+
+            void Clear()
+            {
+                vPageIndex.assign( PAGE_COUNT, 0 );
+                vPages.assign( PAGE_SIZE, 0 );
+                vGlyphs.assign( 1, Glyph() );
+                vFree.clear();
+            }
+
+            // Adds (or replaces) the glyph for a codepoint
+            bool Add( const Glyph& glyph )
+            {
+                uint32_t nPage = glyph.codepoint >> PAGE_BITS;
+                if( nPage >= PAGE_COUNT )
+                    return false;
+
+                if( vPageIndex[nPage] == 0 )
+                {
+                    vPageIndex[nPage] = uint16_t( vPages.size() / PAGE_SIZE );
+                    vPages.resize( vPages.size() + PAGE_SIZE, 0 );
+                }
+
+                uint16_t& nSlot = vPages[ Slot( glyph.codepoint ) ];
+                if( nSlot == 0 && !vFree.empty() )
+                {
+                    nSlot = vFree.back();
+                    vFree.pop_back();
+                }
+                else if( nSlot == 0 )
+                {
+                    if( vGlyphs.size() > UINT16_MAX )
+                        return false;
+                    nSlot = uint16_t( vGlyphs.size() );
+                    vGlyphs.emplace_back();
+                }
+                vGlyphs[nSlot] = glyph;
+                return true;
+            }
+
+            // Forgets the glyph of a codepoint, its slot is reused by a later Add()
+            void Remove( uint32_t nCodepoint )
+            {
+                if( !Contains( nCodepoint ) )
+                    return;
+                uint16_t& nSlot = vPages[ Slot( nCodepoint ) ];
+                vGlyphs[nSlot] = Glyph();
+                vFree.push_back( nSlot );
+                nSlot = 0;
+            }
+
+            // Use the glyph of an existing codepoint for any codepoint the font doesn't contain
+            bool SetReplacement( uint32_t nCodepoint )
+            {
+                if( !Contains( nCodepoint ) )
+                    return false;
+                vGlyphs[0] = Find( nCodepoint );
+                return true;
+            }
+
+            const Glyph& Find( uint32_t nCodepoint ) const
+            {
+                if( (nCodepoint >> PAGE_BITS) >= PAGE_COUNT )
+                    return vGlyphs[0];
+                return vGlyphs[ vPages[ Slot( nCodepoint ) ] ];
+            }
+
+            bool Contains( uint32_t nCodepoint ) const
+            {
+                return (nCodepoint >> PAGE_BITS) < PAGE_COUNT && vPages[ Slot( nCodepoint ) ] != 0;
+            }
+
+            // Number of glyphs, not counting the replacement slot
+            size_t Count() const { return vGlyphs.size() - 1 - vFree.size(); }
+
+            // Adds every codepoint with a glyph to set
+            void Coverage( CoverageSet& set ) const
+            {
+                for( uint32_t nPage = 0; nPage < PAGE_COUNT; nPage++ )
+                {
+                    if( vPageIndex[nPage] == 0 )
+                        continue;
+                    for( uint32_t i = 0; i < PAGE_SIZE; i++ )
+                        if( vPages[ (size_t( vPageIndex[nPage] ) << PAGE_BITS) | i ] != 0 )
+                            set.Add( (nPage << PAGE_BITS) | i );
+                }
+            }
+
+        private:
+            static constexpr uint32_t PAGE_BITS  = 8;
+            static constexpr uint32_t PAGE_SIZE  = 1 << PAGE_BITS;
+            static constexpr uint32_t PAGE_COUNT = 0x110000 >> PAGE_BITS;
+
+            size_t Slot( uint32_t nCodepoint ) const
+            {
+                return (size_t( vPageIndex[nCodepoint >> PAGE_BITS] ) << PAGE_BITS) | (nCodepoint & (PAGE_SIZE - 1));
+            }
+
+            std::vector<uint16_t>   vPageIndex;     // page of each 256 codepoint block, 0 is the shared empty page
+            std::vector<uint16_t>   vPages;         // glyph slot of each codepoint, PAGE_SIZE entries per page
+            std::vector<Glyph>      vGlyphs;        // [0] is the replacement glyph
+            std::vector<uint16_t>   vFree;          // slots released by Remove()
+        };
+
+
+        // The .olcfont metrics file the generators write next to each png. It holds the same
+        // information as the pixels embedded in the png, as fixed size little endian records that
+        // are used where they lie in memory instead of being decoded one pixel at a time:
+        //
+        //   MetricsHeader, then nGlyphs x MetricsGlyph sorted by codepoint
+        struct MetricsHeader
+        {
+            char        magic[4];       // "OLCF"
+            uint32_t    nVersion;
+            uint32_t    nGlyphs;
+            int32_t     nCharWidth;     // cell size used for fixed width drawing
+            int32_t     nCharHeight;    // line height
+            uint32_t    nPages;         // atlas pngs the glyphs are spread over
+            uint32_t    nFlags;         // ATLAS_COVERAGE, ATLAS_GRID
+            uint32_t    nReserved;
+        };
+
+        // The atlas pngs are grayscale and hold only how much of each pixel the glyphs cover
+        constexpr uint32_t ATLAS_COVERAGE = 1;
+
+        // The glyphs sit in cells of nCharWidth x nCharHeight, the layout of pngs with embedded
+        // metrics, so monospaced text can be drawn from the whole cell
+        constexpr uint32_t ATLAS_GRID = 2;
+
+        struct MetricsGlyph
+        {
+            uint32_t    nCodepoint;
+            int16_t     x, y;           // top left of the glyph in its atlas page
+            int16_t     w, h;
+            int16_t     nAdvance;       // pen advance when drawn proportionally
+            uint16_t    nPage;
+        };
+
+        static_assert( sizeof( MetricsHeader ) == 32 && sizeof( MetricsGlyph ) == 16, "the metrics file layout must not be padded" );
+
+        // A validated view over the bytes of a metrics file. The bytes are not copied, so they can
+        // come from a file read, a resource pack or a memory mapping and must outlive the view.
+        class MetricsView
+        {
+        public:
+            static constexpr uint32_t VERSION = 1;
+
+            bool Open( const void* pData, size_t nSize )
+            {
+                header = nullptr; glyphs = nullptr;
+                if( pData == nullptr || nSize < sizeof( MetricsHeader ) || ( uintptr_t( pData ) % alignof( MetricsGlyph ) ) != 0 )
+                    return false;
+
+                auto h = static_cast<const MetricsHeader*>( pData );
+                if( std::string( h->magic, 4 ) != "OLCF" || h->nVersion != VERSION ||
+                    nSize < sizeof( MetricsHeader ) + size_t( h->nGlyphs ) * sizeof( MetricsGlyph ) )
+                    return false;
+
+                header = h;
+                glyphs = reinterpret_cast<const MetricsGlyph*>( h + 1 );
+                return true;
+            }
+
+            bool                    Valid() const   { return header != nullptr; }
+            const MetricsHeader&    Header() const  { return *header; }
+            const MetricsGlyph*     begin() const   { return glyphs; }
+            const MetricsGlyph*     end() const     { return glyphs + header->nGlyphs; }
+
+        private:
+            const MetricsHeader*    header = nullptr;
+            const MetricsGlyph*     glyphs = nullptr;
+        };
+
+        // The metrics file belonging to a font png - the same name with the .olcfont extension
+        inline std::string MetricsFileName( const std::string& sFontFile )
+        {
+            size_t nDot = sFontFile.find_last_of( '.' );
+            size_t nSlash = sFontFile.find_last_of( "/\\" );
+            if( nDot == std::string::npos || ( nSlash != std::string::npos && nDot < nSlash ) )
+                nDot = sFontFile.size();
+            return sFontFile.substr( 0, nDot ) + ".olcfont";
+        }
+
+        // The png holding atlas page nPage of a font - page 0 is the font png itself, the
+        // generators name the others <font>_1.png, <font>_2.png ...
+        inline std::string PageFileName( const std::string& sFontFile, uint32_t nPage )
+        {
+            if( nPage == 0 )
+                return sFontFile;
+            size_t nDot = sFontFile.find_last_of( '.' );
+            size_t nSlash = sFontFile.find_last_of( "/\\" );
+            if( nDot == std::string::npos || ( nSlash != std::string::npos && nDot < nSlash ) )
+                nDot = sFontFile.size();
+            return sFontFile.substr( 0, nDot ) + "_" + std::to_string( nPage ) + sFontFile.substr( nDot );
+        }
+
+        // Reads the metrics file of a font png (from the resource pack when one is given) in one go.
+        // Returns false when there is no metrics file or it isn't one this version understands.
+        inline bool LoadMetrics( const std::string& sFontFile, olc::ResourcePack* pack, std::vector<uint32_t>& vStorage, MetricsView& view )
+        {
+            // uint32_t storage keeps the records aligned
+            std::string sFile = MetricsFileName( sFontFile );
+            vStorage.clear();
+            size_t nSize = 0;
+            if( pack != nullptr )
+            {
+                auto buffer = pack->GetFileBuffer( sFile );
+                nSize = buffer.vMemory.size();
+                vStorage.resize( ( nSize + 3 ) / 4 );
+                if( nSize > 0 )
+                    std::memcpy( vStorage.data(), buffer.vMemory.data(), nSize );
+            }
+            else
+            {
+                std::ifstream file( sFile, std::ios::binary | std::ios::ate );
+                if( !file.is_open() )
+                    return false;
+                nSize = size_t( file.tellg() );
+                vStorage.resize( ( nSize + 3 ) / 4 );
+                file.seekg( 0 );
+                file.read( reinterpret_cast<char*>( vStorage.data() ), std::streamsize( nSize ) );
+                if( !file )
+                    return false;
+            }
+            return view.Open( vStorage.data(), nSize );
+        }
+
+        // 2D affine transform   x' = a*x + b*y + tx,   y' = c*x + d*y + ty
+        struct Affine
+        {
+            float a = 1.0f, b = 0.0f, tx = 0.0f;
+            float c = 0.0f, d = 1.0f, ty = 0.0f;
+
+            // Scale about 'center', rotate by fAngle and move 'center' to 'pos' - the placement
+            // DrawRotatedDecal() gives a sprite, applied here to a whole string at once
+            static Affine Rotation( const olc::vf2d& pos, const float fAngle, const olc::vf2d& center, const olc::vf2d& scale )
+            {
+                float fCos = std::cos( fAngle ), fSin = std::sin( fAngle );
+                Affine m;
+                m.a = fCos * scale.x;   m.b = -fSin * scale.y;
+                m.c = fSin * scale.x;   m.d =  fCos * scale.y;
+                m.tx = pos.x - ( m.a * center.x + m.b * center.y );
+                m.ty = pos.y - ( m.c * center.x + m.d * center.y );
+                return m;
+            }
+        };
+
+
+        // Applies m to n points in place, several points per instruction where the target allows
+        inline void TransformPoints( olc::vf2d* p, size_t n, const Affine& m )
+        {
+            static_assert( sizeof( olc::vf2d ) == 2 * sizeof( float ), "olc::vf2d is expected to be two packed floats" );
+            float* f = &p[0].x;
+            size_t i = 0;
+
+#if defined(__AVX__)
+            const __m256 ac = _mm256_setr_ps( m.a, m.c, m.a, m.c, m.a, m.c, m.a, m.c );
+            const __m256 bd = _mm256_setr_ps( m.b, m.d, m.b, m.d, m.b, m.d, m.b, m.d );
+            const __m256 t  = _mm256_setr_ps( m.tx, m.ty, m.tx, m.ty, m.tx, m.ty, m.tx, m.ty );
+            for( ; i + 4 <= n; i += 4 )
+            {
+                __m256 xy = _mm256_loadu_ps( f + i * 2 );
+                __m256 xx = _mm256_permute_ps( xy, _MM_SHUFFLE( 2, 2, 0, 0 ) );
+                __m256 yy = _mm256_permute_ps( xy, _MM_SHUFFLE( 3, 3, 1, 1 ) );
+                _mm256_storeu_ps( f + i * 2, _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( xx, ac ), _mm256_mul_ps( yy, bd ) ), t ) );
+            }
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+            const __m128 ac = _mm_setr_ps( m.a, m.c, m.a, m.c );
+            const __m128 bd = _mm_setr_ps( m.b, m.d, m.b, m.d );
+            const __m128 t  = _mm_setr_ps( m.tx, m.ty, m.tx, m.ty );
+            for( ; i + 2 <= n; i += 2 )
+            {
+                __m128 xy = _mm_loadu_ps( f + i * 2 );
+                __m128 xx = _mm_shuffle_ps( xy, xy, _MM_SHUFFLE( 2, 2, 0, 0 ) );
+                __m128 yy = _mm_shuffle_ps( xy, xy, _MM_SHUFFLE( 3, 3, 1, 1 ) );
+                _mm_storeu_ps( f + i * 2, _mm_add_ps( _mm_add_ps( _mm_mul_ps( xx, ac ), _mm_mul_ps( yy, bd ) ), t ) );
+            }
+#endif
+            for( ; i < n; i++ )
+            {
+                float x = f[i * 2], y = f[i * 2 + 1];
+                f[i * 2]     = m.a * x + m.b * y + m.tx;
+                f[i * 2 + 1] = m.c * x + m.d * y + m.ty;
+            }
+        }
+
+
+        // Screen area axis aligned text is drawn into. Glyphs outside it are never emitted,
+        // glyphs on its edge are trimmed to it.
+        struct ClipRect
+        {
+            olc::vf2d   tl = { 0.0f, 0.0f };
+            olc::vf2d   br = { 0.0f, 0.0f };
+
+            // The lines [nFirst, nLast) of text whose first line is at y and whose lines are
+            // fLineHeight apart that can overlap the rectangle. Errs on the side of a line too many
+            void VisibleLines( float y, float fLineHeight, size_t& nFirst, size_t& nLast ) const
+            {
+                // Glyphs are snapped down to whole pixels, so a line may start up to 1 pixel higher
+                float fFirst = std::floor( ( tl.y - y ) / fLineHeight );
+                float fLast  = std::ceil( ( br.y + 1.0f - y ) / fLineHeight );
+                nFirst = fFirst > 0.0f ? size_t( fFirst ) : 0;
+                nLast  = fLast  > 0.0f ? ( fLast < float( SIZE_MAX / 2 ) ? size_t( fLast ) : SIZE_MAX ) : 0;
+            }
+        };
+
+        // The text of lines [nFirst, nLast) of s, without the newline ending the last of them
+        inline std::string_view SliceLines( std::string_view s, size_t nFirst, size_t nLast )
+        {
+            if( nLast <= nFirst )
+                return {};
+
+            size_t nStart = 0;
+            for( size_t n = 0; n < nFirst; n++ )
+            {
+                const void* p = std::memchr( s.data() + nStart, '\n', s.size() - nStart );
+                if( p == nullptr )
+                    return {};
+                nStart = size_t( static_cast<const char*>( p ) - s.data() ) + 1;
+            }
+
+            size_t nEnd = nStart;
+            for( size_t n = nFirst; n < nLast; n++ )
+            {
+                const void* p = std::memchr( s.data() + nEnd, '\n', s.size() - nEnd );
+                if( p == nullptr )
+                    return s.substr( nStart );
+                nEnd = size_t( static_cast<const char*>( p ) - s.data() ) + ( n + 1 < nLast ? 1 : 0 );
+            }
+            return s.substr( nStart, nEnd - nStart );
+        }
+
+
+        // Collects glyph quads so a whole string - or many strings drawn with the same font - is
+        // handed to the engine as a few triangle lists rather than one decal instance per glyph.
+        // Fonts whose atlas is split over several pages submit one list per page.
+        class GlyphBatch
+        {
+        public:
+            // Axis aligned glyph, drawn exactly where DrawPartialDecal() would put it
+            void AddGlyph( const olc::vf2d& pos, const olc::vi2d& sourcePos, const olc::vf2d& sourceSize, const olc::vf2d& scale,
+                           const olc::vf2d& uvScale, const olc::Pixel col, const uint32_t page = 0 )
+            {
+                olc::vf2d tl = { std::floor( pos.x ), std::floor( pos.y ) };
+                AddQuad( tl, tl + sourceSize * scale, olc::vf2d( sourcePos ), sourceSize, uvScale, col, page );
+            }
+
+            // As AddGlyph(), less the parts of the glyph outside clip. Returns false if nothing
+            // of it was inside. Only for positive scales
+            bool AddClippedGlyph( const olc::vf2d& pos, const olc::vi2d& sourcePos, const olc::vf2d& sourceSize, const olc::vf2d& scale,
+                                  const olc::vf2d& uvScale, const olc::Pixel col, const ClipRect& clip, const uint32_t page = 0 )
+            {
+                olc::vf2d tl = { std::floor( pos.x ), std::floor( pos.y ) };
+                olc::vf2d br = tl + sourceSize * scale;
+                olc::vf2d ctl = { std::max( tl.x, clip.tl.x ), std::max( tl.y, clip.tl.y ) };
+                olc::vf2d cbr = { std::min( br.x, clip.br.x ), std::min( br.y, clip.br.y ) };
+                if( cbr.x <= ctl.x || cbr.y <= ctl.y )
+                    return false;
+
+                // Trim the source rectangle by as much as the quad was trimmed
+                olc::vf2d srcTL = olc::vf2d( sourcePos ) + ( ctl - tl ) / scale;
+                olc::vf2d srcBR = olc::vf2d( sourcePos ) + ( cbr - tl ) / scale;
+                AddQuad( ctl, cbr, srcTL, srcBR - srcTL, uvScale, col, page );
+                return true;
+            }
+
+            // Glyph at 'offset' in text space, unscaled. Move it into place with Transform()
+            void AddLocalGlyph( const olc::vf2d& offset, const olc::vi2d& sourcePos, const olc::vf2d& sourceSize,
+                                const olc::vf2d& uvScale, const olc::Pixel col, const uint32_t page = 0 )
+            {
+                AddQuad( offset, offset + sourceSize, olc::vf2d( sourcePos ), sourceSize, uvScale, col, page );
+            }
+
+            // Number of corners collected so far, mark the start of a string for Transform()
+            size_t Corners() const { return vCorners.size(); }
+
+            // Applies one transform to every corner added since nFirstCorner
+            void Transform( size_t nFirstCorner, const Affine& m )
+            {
+                if( nFirstCorner < vCorners.size() )
+                    TransformPoints( &vCorners[nFirstCorner], vCorners.size() - nFirstCorner, m );
+            }
+
+            // Number of glyphs collected so far
+            size_t Quads() const { return vQuads.size(); }
+
+            // Hands everything collected so far to the engine and empties the batch. Returns
+            // the number of decal instances it took
+            size_t Submit( olc::PixelGameEngine* pge, olc::Decal* decal )
+            {
+                if( vQuads.empty() )
+                    return 0;
+
+                size_t nInstances = SubmitQuads( pge, decal, nullptr, vQuads.size() );
+                Clear();
+                return nInstances;
+            }
+
+            // As above for a font with several atlas pages, decals[i] being page i. The quads of
+            // each page are submitted together, in the order they were added
+            size_t Submit( olc::PixelGameEngine* pge, const std::unique_ptr<olc::Decal>* decals, size_t nPages )
+            {
+                if( vQuads.empty() )
+                    return 0;
+
+                if( nPages <= 1 )
+                {
+                    size_t nInstances = SubmitQuads( pge, decals[0].get(), nullptr, vQuads.size() );
+                    Clear();
+                    return nInstances;
+                }
+
+                // Counting sort of the quad indices by page
+                vPageStart.assign( nPages + 1, 0 );
+                for( auto& quad : vQuads )
+                    vPageStart[ std::min<size_t>( quad.page, nPages - 1 ) + 1 ]++;
+                for( size_t p = 0; p < nPages; p++ )
+                    vPageStart[p + 1] += vPageStart[p];
+                vOrder.resize( vQuads.size() );
+                vPageFill.assign( vPageStart.begin(), vPageStart.end() - 1 );
+                for( size_t q = 0; q < vQuads.size(); q++ )
+                    vOrder[ vPageFill[ std::min<size_t>( vQuads[q].page, nPages - 1 ) ]++ ] = uint32_t( q );
+
+                size_t nInstances = 0;
+                for( size_t p = 0; p < nPages; p++ )
+                    if( vPageStart[p + 1] > vPageStart[p] )
+                        nInstances += SubmitQuads( pge, decals[p].get(), vOrder.data() + vPageStart[p], vPageStart[p + 1] - vPageStart[p] );
+                Clear();
+                return nInstances;
+            }
+
+            // Moves the glyphs of another batch onto the end of this one
+            void Append( GlyphBatch& other )
+            {
+                vCorners.insert( vCorners.end(), other.vCorners.begin(), other.vCorners.end() );
+                vQuads.insert( vQuads.end(), other.vQuads.begin(), other.vQuads.end() );
+                other.Clear();
+            }
+
+            void Clear()
+            {
+                vCorners.clear();
+                vQuads.clear();
+            }
+
+            bool Empty() const { return vQuads.empty(); }
+
+        private:
+            struct Quad
+            {
+                olc::vf2d   uvtl;
+                olc::vf2d   uvbr;
+                olc::Pixel  col;
+                uint32_t    page;
+            };
+
+            // Submits nQuads quads - pOrder[0..nQuads) when given, otherwise the first nQuads.
+            // Returns the number of decal instances drawn
+            size_t SubmitQuads( olc::PixelGameEngine* pge, olc::Decal* decal, const uint32_t* pOrder, size_t nQuads )
+            {
+                constexpr size_t nMaxQuads = OLC_PGEX_FONT_MAX_BATCH_VERTS / 6;
+                static_assert( nMaxQuads >= 1, "OLC_PGEX_FONT_MAX_BATCH_VERTS must allow at least one glyph" );
+                olc::vf2d  vPos[nMaxQuads * 6];
+                olc::vf2d  vUV[nMaxQuads * 6];
+                olc::Pixel vCol[nMaxQuads * 6];
+
+                // Expand each quad to the two triangles (tl, bl, br) (tl, br, tr)
+                size_t nInstances = 0;
+                pge->SetDecalStructure( olc::DecalStructure::LIST );
+                for( size_t i = 0; i < nQuads; nInstances++ )
+                {
+                    uint32_t nVerts = 0;
+                    for( size_t n = 0; n < nMaxQuads && i < nQuads; n++, i++ )
+                    {
+                        const size_t q = pOrder != nullptr ? pOrder[i] : i;
+                        const olc::vf2d* corner = &vCorners[q * 4];
+                        const Quad& quad = vQuads[q];
+                        const olc::vf2d uv[4] = { quad.uvtl, { quad.uvtl.x, quad.uvbr.y }, quad.uvbr, { quad.uvbr.x, quad.uvtl.y } };
+                        for( int k : { 0, 1, 2, 0, 2, 3 } )
+                        {
+                            vPos[nVerts] = corner[k];
+                            vUV[nVerts]  = uv[k];
+                            vCol[nVerts] = quad.col;
+                            nVerts++;
+                        }
+                    }
+                    pge->DrawExplicitDecal( decal, vPos, vUV, vCol, nVerts );
+                }
+                pge->SetDecalStructure( olc::DecalStructure::FAN );
+                return nInstances;
+            }
+
+            void AddQuad( const olc::vf2d& tl, const olc::vf2d& br, const olc::vf2d& sourcePos, const olc::vf2d& sourceSize,
+                          const olc::vf2d& uvScale, const olc::Pixel col, const uint32_t page )
+            {
+                vCorners.push_back( tl );
+                vCorners.push_back( { tl.x, br.y } );
+                vCorners.push_back( br );
+                vCorners.push_back( { br.x, tl.y } );
+                vQuads.push_back( { sourcePos * uvScale, ( sourcePos + sourceSize ) * uvScale, col, page } );
+            }
+
+            std::vector<olc::vf2d>  vCorners;       // 4 per quad: tl, bl, br, tr
+            std::vector<Quad>       vQuads;
+            std::vector<uint32_t>   vOrder;         // quad indices grouped by page, see Submit()
+            std::vector<size_t>     vPageStart;
+            std::vector<size_t>     vPageFill;
+        };
+
+
+        // Threads kept waiting for lists of independent jobs, see BasicFont::DrawLabelsDecal().
+        // Run() hands out the jobs one at a time from a shared counter, so a thread that finishes
+        // its job early simply takes the next one and the work evens out by itself.
+        class WorkerPool
+        {
+        public:
+            // nThreads counts the thread calling Run(), which works along with the pool's own
+            WorkerPool( uint32_t nThreads )
+            {
+                for( uint32_t i = 1; i < std::max( nThreads, 1u ); i++ )
+                    vThreads.emplace_back( &WorkerPool::Worker, this, i );
+            }
+
+            ~WorkerPool()
+            {
+                {
+                    std::unique_lock<std::mutex> lock( mux );
+                    bStop = true;
+                }
+                cvStart.notify_all();
+                for( auto& t : vThreads )
+                    t.join();
+            }
+
+            uint32_t Workers() const { return uint32_t( vThreads.size() ) + 1; }
+
+            // Calls job( i, worker ) for every i in [0, nJobs) and returns when they are all done.
+            // worker, below Workers(), tells the threads apart - the caller is worker 0.
+            void Run( size_t nJobs, const std::function<void(size_t, uint32_t)>& job )
+            {
+                {
+                    std::unique_lock<std::mutex> lock( mux );
+                    pJob = &job;
+                    nJobCount = nJobs;
+                    nNextJob = 0;
+                    nBusy = uint32_t( vThreads.size() );
+                    nGeneration++;
+                }
+                cvStart.notify_all();
+
+                Work( 0 );
+
+                std::unique_lock<std::mutex> lock( mux );
+                cvDone.wait( lock, [this] { return nBusy == 0; } );
+                pJob = nullptr;
+            }
+
+        private:
+            void Work( uint32_t nWorker )
+            {
+                for( size_t i = nNextJob++; i < nJobCount; i = nNextJob++ )
+                    (*pJob)( i, nWorker );
+            }
+
+            void Worker( uint32_t nWorker )
+            {
+                uint64_t nSeen = 0;
+                for( ;; )
+                {
+                    {
+                        std::unique_lock<std::mutex> lock( mux );
+                        cvStart.wait( lock, [&] { return bStop || nGeneration != nSeen; } );
+                        if( bStop )
+                            return;
+                        nSeen = nGeneration;
+                    }
+
+                    Work( nWorker );
+
+                    std::unique_lock<std::mutex> lock( mux );
+                    if( --nBusy == 0 )
+                        cvDone.notify_one();
+                }
+            }
+
+            std::vector<std::thread>                        vThreads;
+            std::mutex                                      mux;
+            std::condition_variable                         cvStart;
+            std::condition_variable                         cvDone;
+            const std::function<void(size_t, uint32_t)>*    pJob = nullptr;
+            size_t                                          nJobCount = 0;
+            std::atomic<size_t>                             nNextJob{ 0 };
+            uint32_t                                        nBusy = 0;
+            uint64_t                                        nGeneration = 0;
+            bool                                            bStop = false;
+        };
+
+
+        // pages[i] is the decal of atlas page i
+        inline void BatchLayout( olc::font::GlyphBatch& batch, const std::unique_ptr<olc::Decal>* pages, const olc::vf2d& pos, const olc::TextLayout& layout,
+                                 const olc::Pixel col, const olc::vf2d& scale )
+        {
+            for( auto& glyph : layout.vGlyphs )
+                batch.AddGlyph( pos + glyph.offset * scale, glyph.sourcePos, glyph.sourceSize, scale, pages[glyph.page]->vUVScale, col, glyph.page );
+        }
+
+
+        // As above, only emitting what is inside clip. Lines above and below it are skipped
+        // without looking at their glyphs, and each line stops at the right edge.
+        inline void BatchLayout( olc::font::GlyphBatch& batch, const std::unique_ptr<olc::Decal>* pages, const olc::vf2d& pos, const olc::TextLayout& layout,
+                                 const olc::Pixel col, const olc::vf2d& scale, const ClipRect& clip )
+        {
+            if( scale.x <= 0.0f || scale.y <= 0.0f || layout.vLineStarts.empty() )
+            {
+                BatchLayout( batch, pages, pos, layout, col, scale );
+                return;
+            }
+
+            const size_t nLines = layout.vLineStarts.size();
+            size_t nFirst, nLast;
+            clip.VisibleLines( pos.y, float( layout.size.y ) / float( nLines ) * scale.y, nFirst, nLast );
+            nLast = std::min( nLast, nLines );
+            for( size_t line = nFirst; line < nLast; line++ )
+            {
+                size_t nEnd = line + 1 < nLines ? layout.vLineStarts[line + 1] : layout.vGlyphs.size();
+                for( size_t i = layout.vLineStarts[line]; i < nEnd; i++ )
+                {
+                    auto& glyph = layout.vGlyphs[i];
+                    olc::vf2d gpos = pos + glyph.offset * scale;
+                    if( std::floor( gpos.x ) >= clip.br.x )
+                        break;
+                    batch.AddClippedGlyph( gpos, glyph.sourcePos, glyph.sourceSize, scale, pages[glyph.page]->vUVScale, col, clip, glyph.page );
+                }
+            }
+        }
+
+
+        inline void BatchRotatedLayout( olc::font::GlyphBatch& batch, const std::unique_ptr<olc::Decal>* pages, const olc::vf2d& pos, const olc::TextLayout& layout,
+                                        const float fAngle, const olc::vf2d& center, const olc::Pixel col, const olc::vf2d& scale )
+        {
+            size_t nFirst = batch.Corners();
+            for( auto& glyph : layout.vGlyphs )
+                batch.AddLocalGlyph( glyph.offset, glyph.sourcePos, glyph.sourceSize, pages[glyph.page]->vUVScale, col, glyph.page );
+            batch.Transform( nFirst, Affine::Rotation( pos, fAngle, center, scale ) );
+        }
+
+
+        // Composites n source pixels over n destination pixels ("source over", straight alpha).
+        // The vector paths use exactly the same float operations as the scalar one, so the
+        // result is the same whichever path the build selects.
+        inline void BlendRow( olc::Pixel* dst, const olc::Pixel* src, size_t n )
+        {
+            size_t i = 0;
+            const float k = 1.0f / 255.0f;
+
+#if defined(__AVX2__)
+            const __m256 vK     = _mm256_set1_ps( k );
+            const __m256 vOne   = _mm256_set1_ps( 1.0f );
+            const __m256 v255   = _mm256_set1_ps( 255.0f );
+            const __m256 vHalf  = _mm256_set1_ps( 0.5f );
+            const __m256 vEps   = _mm256_set1_ps( 1e-6f );
+            const __m256 vRGB   = _mm256_castsi256_ps( _mm256_setr_epi32( -1, -1, -1, 0, -1, -1, -1, 0 ) );
+            for( ; i + 2 <= n; i += 2 )
+            {
+                __m256 s  = _mm256_cvtepi32_ps( _mm256_cvtepu8_epi32( _mm_loadl_epi64( (const __m128i*)( src + i ) ) ) );
+                __m256 d  = _mm256_cvtepi32_ps( _mm256_cvtepu8_epi32( _mm_loadl_epi64( (const __m128i*)( dst + i ) ) ) );
+                __m256 sa = _mm256_mul_ps( _mm256_permute_ps( s, 0xFF ), vK );
+                __m256 da = _mm256_mul_ps( _mm256_permute_ps( d, 0xFF ), vK );
+                __m256 wd = _mm256_mul_ps( da, _mm256_sub_ps( vOne, sa ) );
+                __m256 oa = _mm256_add_ps( sa, wd );
+                __m256 c  = _mm256_div_ps( _mm256_add_ps( _mm256_mul_ps( s, sa ), _mm256_mul_ps( d, wd ) ), _mm256_max_ps( oa, vEps ) );
+                __m256 r  = _mm256_or_ps( _mm256_and_ps( vRGB, c ), _mm256_andnot_ps( vRGB, _mm256_mul_ps( oa, v255 ) ) );
+                __m256i q = _mm256_cvttps_epi32( _mm256_add_ps( r, vHalf ) );
+                __m128i w = _mm_packs_epi32( _mm256_castsi256_si128( q ), _mm256_extractf128_si256( q, 1 ) );
+                _mm_storel_epi64( (__m128i*)( dst + i ), _mm_packus_epi16( w, w ) );
+            }
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+            const __m128  vK    = _mm_set1_ps( k );
+            const __m128  vOne  = _mm_set1_ps( 1.0f );
+            const __m128  v255  = _mm_set1_ps( 255.0f );
+            const __m128  vHalf = _mm_set1_ps( 0.5f );
+            const __m128  vEps  = _mm_set1_ps( 1e-6f );
+            const __m128  vRGB  = _mm_castsi128_ps( _mm_setr_epi32( -1, -1, -1, 0 ) );
+            const __m128i vZero = _mm_setzero_si128();
+            for( ; i < n; i++ )
+            {
+                __m128 s  = _mm_cvtepi32_ps( _mm_unpacklo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( int( src[i].n ) ), vZero ), vZero ) );
+                __m128 d  = _mm_cvtepi32_ps( _mm_unpacklo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( int( dst[i].n ) ), vZero ), vZero ) );
+                __m128 sa = _mm_mul_ps( _mm_shuffle_ps( s, s, 0xFF ), vK );
+                __m128 da = _mm_mul_ps( _mm_shuffle_ps( d, d, 0xFF ), vK );
+                __m128 wd = _mm_mul_ps( da, _mm_sub_ps( vOne, sa ) );
+                __m128 oa = _mm_add_ps( sa, wd );
+                __m128 c  = _mm_div_ps( _mm_add_ps( _mm_mul_ps( s, sa ), _mm_mul_ps( d, wd ) ), _mm_max_ps( oa, vEps ) );
+                __m128 r  = _mm_or_ps( _mm_and_ps( vRGB, c ), _mm_andnot_ps( vRGB, _mm_mul_ps( oa, v255 ) ) );
+                __m128i q = _mm_cvttps_epi32( _mm_add_ps( r, vHalf ) );
+                q = _mm_packs_epi32( q, q );
+                dst[i].n = uint32_t( _mm_cvtsi128_si32( _mm_packus_epi16( q, q ) ) );
+            }
+#endif
+            for( ; i < n; i++ )
+            {
+                const olc::Pixel s = src[i], d = dst[i];
+                float sa = float( s.a ) * k;
+                float da = float( d.a ) * k;
+                float wd = da * ( 1.0f - sa );
+                float oa = sa + wd;
+                float inv = std::max( oa, 1e-6f );
+                auto channel = [&]( uint8_t sc, uint8_t dc )
+                {
+                    return uint8_t( std::min( int( ( float( sc ) * sa + float( dc ) * wd ) / inv + 0.5f ), 255 ) );
+                };
+                dst[i] = olc::Pixel( channel( s.r, d.r ), channel( s.g, d.g ), channel( s.b, d.b ), uint8_t( std::min( int( oa * 255.0f + 0.5f ), 255 ) ) );
+            }
+        }
+
+
+        // An atlas page kept as one byte per pixel: how much of the pixel the glyphs cover. The
+        // colour of text always comes from the tint, so for white glyphs this is all there is to
+        // an atlas, at a quarter of the memory of the sprite.
+        struct CoveragePage
+        {
+            int32_t                 width = 0;
+            int32_t                 height = 0;
+            std::vector<uint8_t>    vData;
+
+            // Alpha times brightness, which reads white glyphs on a transparent background and
+            // grayscale pngs (loaded as opaque gray) alike
+            static CoveragePage FromSprite( olc::Sprite* sprite )
+            {
+                CoveragePage page;
+                page.width = sprite->width;
+                page.height = sprite->height;
+                page.vData.resize( size_t( page.width ) * size_t( page.height ) );
+                const olc::Pixel* pSrc = sprite->GetData();
+                for( size_t i = 0; i < page.vData.size(); i++ )
+                    page.vData[i] = uint8_t( ( uint32_t( pSrc[i].r ) * pSrc[i].a + 127 ) / 255 );
+                return page;
+            }
+
+            // White with the coverage as alpha, as the decals are uploaded from
+            std::unique_ptr<olc::Sprite> ToSprite() const
+            {
+                auto sprite = std::make_unique<olc::Sprite>( width, height );
+                olc::Pixel* pDst = sprite->GetData();
+                for( size_t i = 0; i < vData.size(); i++ )
+                    pDst[i] = olc::Pixel( 255, 255, 255, vData[i] );
+                return sprite;
+            }
+        };
+
+        // The two kinds of atlas page the software renderer draws from
+        inline olc::vi2d PageSize( const std::unique_ptr<olc::Sprite>& page ) { return page ? olc::vi2d( page->width, page->height ) : olc::vi2d( 0, 0 ); }
+        inline olc::vi2d PageSize( const CoveragePage& page ) { return { page.width, page.height }; }
+        inline const olc::Pixel* PageRow( const std::unique_ptr<olc::Sprite>& page, int32_t y ) { return page->GetData() + size_t( y ) * page->width; }
+        inline const uint8_t* PageRow( const CoveragePage& page, int32_t y ) { return page.vData.data() + size_t( y ) * page.width; }
+
+
+        // Draws the rows [y0, y1) of a layout into a sprite, see RasterLayout()
+        template<class Page>
+        inline void RasterLayoutBand( olc::Sprite* target, const Page* pages, const size_t nPages, const olc::vi2d& pos,
+                                      const olc::TextLayout& layout, const olc::Pixel col, const int32_t scale, const int32_t y0, const int32_t y1 )
+        {
+            auto tint = []( uint8_t a, uint8_t b ) { uint32_t x = uint32_t( a ) * b + 128; return uint8_t( ( x + ( x >> 8 ) ) >> 8 ); };
+            auto texel = [&]( auto p )
+            {
+                if constexpr( std::is_same_v<decltype( p ), uint8_t> )
+                    return olc::Pixel( col.r, col.g, col.b, tint( p, col.a ) );
+                else
+                    return olc::Pixel( tint( p.r, col.r ), tint( p.g, col.g ), tint( p.b, col.b ), tint( p.a, col.a ) );
+            };
+
+            std::vector<olc::Pixel> vRow;
+            olc::Pixel* pTarget = target->GetData();
+
+            for( auto& glyph : layout.vGlyphs )
+            {
+                if( glyph.page >= nPages )
+                    continue;
+                const Page& atlas = pages[glyph.page];
+                const olc::vi2d atlasSize = PageSize( atlas );
+
+                // Clip the source rectangle to the atlas, then the scaled glyph to the band and target
+                olc::vi2d srcTL = { std::max( glyph.sourcePos.x, 0 ), std::max( glyph.sourcePos.y, 0 ) };
+                olc::vi2d srcBR = { std::min( glyph.sourcePos.x + glyph.sourceSize.x, atlasSize.x ),
+                                    std::min( glyph.sourcePos.y + glyph.sourceSize.y, atlasSize.y ) };
+                if( srcBR.x <= srcTL.x || srcBR.y <= srcTL.y )
+                    continue;
+
+                olc::vi2d origin = { pos.x + int32_t( std::floor( glyph.offset.x ) ) * scale, pos.y + int32_t( std::floor( glyph.offset.y ) ) * scale };
+                int32_t gx0 = std::max( origin.x + ( srcTL.x - glyph.sourcePos.x ) * scale, 0 );
+                int32_t gx1 = std::min( origin.x + ( srcBR.x - glyph.sourcePos.x ) * scale, target->width );
+                int32_t gy0 = std::max( { origin.y + ( srcTL.y - glyph.sourcePos.y ) * scale, y0, 0 } );
+                int32_t gy1 = std::min( { origin.y + ( srcBR.y - glyph.sourcePos.y ) * scale, y1, target->height } );
+                if( gx1 <= gx0 || gy1 <= gy0 )
+                    continue;
+
+                vRow.resize( size_t( gx1 - gx0 ) );
+                for( int32_t y = gy0; y < gy1; y++ )
+                {
+                    auto pSrc = PageRow( atlas, glyph.sourcePos.y + ( y - origin.y ) / scale );
+                    for( int32_t x = gx0; x < gx1; x++ )
+                        vRow[x - gx0] = texel( pSrc[glyph.sourcePos.x + ( x - origin.x ) / scale] );
+                    BlendRow( pTarget + size_t( y ) * target->width + gx0, vRow.data(), vRow.size() );
+                }
+            }
+        }
+
+
+        // Software renders a layout into a sprite with the glyphs of the atlas pages, tinted by col
+        // and alpha blended over what is already there. Given a pool the text is split into
+        // horizontal bands, one per worker, drawn at the same time with each thread owning its rows.
+        template<class Page>
+        inline void RasterLayout( olc::Sprite* target, const Page* pages, const size_t nPages, const olc::vi2d& pos,
+                                  const olc::TextLayout& layout, const olc::Pixel col, const uint32_t scale, WorkerPool* pool = nullptr )
+        {
+            if( target == nullptr || pages == nullptr || nPages == 0 || scale == 0 )
+                return;
+
+            int32_t y0 = std::max( pos.y, 0 );
+            int32_t y1 = std::min( pos.y + layout.size.y * int32_t( scale ), target->height );
+            if( y1 <= y0 )
+                return;
+
+            // Not worth waking threads for less than a few rows each
+            constexpr int32_t nMinBandRows = 16;
+            uint32_t nBands = std::min( pool != nullptr ? pool->Workers() : 1u, uint32_t( ( y1 - y0 + nMinBandRows - 1 ) / nMinBandRows ) );
+            if( nBands <= 1 )
+            {
+                RasterLayoutBand( target, pages, nPages, pos, layout, col, int32_t( scale ), y0, y1 );
+                return;
+            }
+
+            const int32_t nRows = ( y1 - y0 + int32_t( nBands ) - 1 ) / int32_t( nBands );
+            pool->Run( nBands, [&]( size_t nBand, uint32_t )
+            {
+                const int32_t y = y0 + int32_t( nBand ) * nRows;
+                if( y < y1 )
+                    RasterLayoutBand( target, pages, nPages, pos, layout, col, int32_t( scale ), y, std::min( y + nRows, y1 ) );
+            } );
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,236 @@
+#pragma once
+
+#ifndef __OLC_PGEX_FONTLOADER__
+#define __OLC_PGEX_FONTLOADER__
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "olcPixelGameEngine.h"
+#include "olcPGEX_Font.h"
+#include "olcPGEX_CustomFont.h"
+
+namespace olc
+{
+    // A font that is being loaded by a FontLoader. Get() returns nullptr until the font is ready
+    // to draw with, Or() substitutes a fallback font in the meantime. Copies share the same font.
+    template<class TFont>
+    class FontHandle
+    {
+    public:
+        FontHandle() = default;
+
+        bool Ready() const { return state && state->bReady; }
+        TFont* Get() const { return Ready() ? state->font.get() : nullptr; }
+        TFont& Or(TFont& fallback) const { TFont* font = Get(); return font != nullptr ? *font : fallback; }
+
+    private:
+        friend class FontLoader;
+
+        struct State
+        {
+            std::unique_ptr<TFont>  font;
+            bool                    bReady = false;     // only touched on the main thread
+        };
+
+        std::shared_ptr<State>  state;
+    };
+
+
+    // Loads fonts on a pool of worker threads. Decoding the pngs and reading the metrics happens on
+    // the workers; the decals, which have to be created on the engine's thread, are made by Pump().
+    // Pump() is called automatically before every OnUserUpdate(), so fonts simply become ready a
+    // frame or so after they are requested. The loader is a member of the game, alive as long as the engine:
+    //
+    //     // OnUserCreate
+    //     loader = std::make_unique<olc::FontLoader>();
+    //     title  = loader->LoadFont( "title.png" );
+    //
+    //     // OnUserUpdate
+    //     title.Or( *defaultFont ).DrawStringDecal( { 10, 10 }, "Hello" );
+    //
+    // FontLoader hooks into the engine, so create it once the engine is running (OnUserCreate). The
+    // engine keeps a pointer to every hooked extension and has no way to forget one, so a hooked
+    // loader must live as long as the engine does - hold it as a member, never reset or destroy it
+    // early. A loader that should go away sooner is made with bHook = false and the game calls
+    // Pump() itself each frame, eg. at the top of OnUserUpdate():
+    //
+    //     loader = std::make_unique<olc::FontLoader>( 0, false );
+    //     ...
+    //     loader->Pump();      // OnUserUpdate
+    //     ...
+    //     loader.reset();      // fine, the engine never saw it
+    //
+    // Fonts from a resource pack are read one at a time, as a pack can't be read by several threads.
+    class FontLoader : public olc::PGEX
+    {
+    public:
+        // nThreads = 0 uses one worker per hardware thread. bHook = false leaves calling Pump() to the game
+        FontLoader(uint32_t nThreads = 0, bool bHook = true);
+        ~FontLoader();
+
+        FontHandle<olc::Font> LoadFont(const std::string& sFontFile, olc::ResourcePack* pack = nullptr);
+        FontHandle<olc::CustomFont> LoadCustomFont(const std::string& sFontFile, olc::ResourcePack* pack = nullptr);
+
+        // Creates the decals of every font the workers have finished. Main thread only
+        void Pump();
+
+        // Blocks until every requested font has loaded, then pumps them. Main thread only
+        void WaitAll();
+
+        // Fonts requested but not yet ready
+        size_t Pending() const;
+
+    protected:
+        bool OnBeforeUserUpdate(float& fElapsedTime) override;
+
+    private:
+        template<class TFont> FontHandle<TFont> Load(const std::string& sFontFile, olc::ResourcePack* pack);
+        void Worker();
+
+    private:
+        std::vector<std::thread>            vWorkers;
+        mutable std::mutex                  mux;
+        std::condition_variable             cvJobs;
+        std::condition_variable             cvDone;
+        std::deque<std::function<void()>>   qJobs;          // run on a worker
+        std::vector<std::function<void()>>  vFinished;      // run on the main thread by Pump()
+        size_t                              nPending = 0;   // requested, not yet pumped
+        size_t                              nLoading = 0;   // requested, not yet finished by a worker
+        bool                                bStop = false;
+        std::mutex                          muxPack;
+    };
+
+
+    template<class TFont>
+    FontHandle<TFont> FontLoader::Load(const std::string& sFontFile, olc::ResourcePack* pack)
+    {
+        FontHandle<TFont> handle;
+        handle.state = std::make_shared<typename FontHandle<TFont>::State>();
+        auto state = handle.state;
+
+        std::unique_lock<std::mutex> lock( mux );
+        nPending++;
+        nLoading++;
+        qJobs.push_back( [this, state, sFontFile, pack]()
+        {
+            {
+                std::unique_lock<std::mutex> lockPack( muxPack, std::defer_lock );
+                if( pack != nullptr )
+                    lockPack.lock();
+                state->font = std::make_unique<TFont>( sFontFile, pack, olc::font::DeferDecals );
+            }
+
+            std::unique_lock<std::mutex> lock( mux );
+            vFinished.push_back( [state]() { state->font->CreateDecals(); state->bReady = true; } );
+            nLoading--;
+            cvDone.notify_all();
+        } );
+        cvJobs.notify_one();
+        return handle;
+    }
+}
+
+
+#ifdef OLC_PGEX_FONTLOADER
+#undef OLC_PGEX_FONTLOADER
+
+namespace olc
+{
+    FontLoader::FontLoader(uint32_t nThreads, bool bHook) : olc::PGEX(bHook)
+    {
+        if( nThreads == 0 )
+            nThreads = std::max( std::thread::hardware_concurrency(), 1u );
+        for( uint32_t i = 0; i < nThreads; i++ )
+            vWorkers.emplace_back( &FontLoader::Worker, this );
+    }
+
+
+    FontLoader::~FontLoader()
+    {
+        {
+            std::unique_lock<std::mutex> lock( mux );
+            bStop = true;
+            qJobs.clear();
+        }
+        cvJobs.notify_all();
+        for( auto& t : vWorkers )
+            t.join();
+    }
+
+
+    void FontLoader::Worker()
+    {
+        for( ;; )
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock( mux );
+                cvJobs.wait( lock, [this] { return bStop || !qJobs.empty(); } );
+                if( bStop )
+                    return;
+                job = std::move( qJobs.front() );
+                qJobs.pop_front();
+            }
+            job();
+        }
+    }
+
+
+    FontHandle<olc::Font> FontLoader::LoadFont(const std::string& sFontFile, olc::ResourcePack* pack)
+    {
+        return Load<olc::Font>( sFontFile, pack );
+    }
+
+
+    FontHandle<olc::CustomFont> FontLoader::LoadCustomFont(const std::string& sFontFile, olc::ResourcePack* pack)
+    {
+        return Load<olc::CustomFont>( sFontFile, pack );
+    }
+
+
+    void FontLoader::Pump()
+    {
+        std::vector<std::function<void()>> vReady;
+        {
+            std::unique_lock<std::mutex> lock( mux );
+            vReady.swap( vFinished );
+            nPending -= vReady.size();
+        }
+
+        for( auto& finish : vReady )
+            finish();
+    }
+
+
+    void FontLoader::WaitAll()
+    {
+        {
+            std::unique_lock<std::mutex> lock( mux );
+            cvDone.wait( lock, [this] { return nLoading == 0; } );
+        }
+        Pump();
+    }
+
+
+    size_t FontLoader::Pending() const
+    {
+        std::unique_lock<std::mutex> lock( mux );
+        return nPending;
+    }
+
+
+    bool FontLoader::OnBeforeUserUpdate(float&)
+    {
+        Pump();
+        return false;
+    }
+}
+
+#endif
+#endif
@@ -0,0 +1,148 @@
+#pragma once
+
+#ifndef __OLC_PGEX_FONTREGISTRY__
+#define __OLC_PGEX_FONTREGISTRY__
+
+#include <map>
+#include <vector>
+#include <memory>
+#include <string>
+#include "olcPixelGameEngine.h"
+#include "olcPGEX_Font.h"
+#include "olcPGEX_CustomFont.h"
+
+namespace olc
+{
+    // Hands out shared fonts, so a png asked for by several scenes or widgets is decoded and
+    // uploaded once. Fonts are keyed by file and resource pack; the first request loads the font,
+    // later ones get the same font for as long as anyone still holds it. A font is freed as soon
+    // as its last handle goes, so a scene keeping its fonts until the next scene has asked for its
+    // own carries the shared ones across instead of loading them twice:
+    //
+    //     // OnUserCreate
+    //     registry = std::make_unique<olc::FontRegistry>();
+    //
+    //     // in each scene
+    //     std::shared_ptr<olc::Font> font = registry->GetFont( "Arial.png" );
+    //
+    // Fonts create their decals as they load, so use it on the engine's thread once the engine is
+    // running. Handles may outlive the registry.
+    class FontRegistry
+    {
+    public:
+        // bKeepSprites = false frees the atlas sprites of every font once its decals exist, halving
+        // the memory a font takes. Software rendering (DrawString into a sprite) then draws nothing.
+        FontRegistry(bool bKeepSprites = true);
+
+        std::shared_ptr<olc::Font> GetFont(const std::string& sFontFile, olc::ResourcePack* pack = nullptr);
+        std::shared_ptr<olc::CustomFont> GetCustomFont(const std::string& sFontFile, olc::ResourcePack* pack = nullptr);
+
+        struct FontInfo
+        {
+            std::string         sFontFile;
+            olc::ResourcePack*  pack = nullptr;
+            bool                bCustom = false;        // olc::CustomFont, otherwise olc::Font
+            long                nUsers = 0;             // handles held outside the registry
+            size_t              nSpriteBytes = 0;
+            size_t              nTextureBytes = 0;
+        };
+
+        // The fonts currently loaded, and the memory they hold in total
+        std::vector<FontInfo> Fonts() const;
+        size_t SpriteBytes() const;
+        size_t TextureBytes() const;
+
+    private:
+        typedef std::pair<std::string, olc::ResourcePack*> Key;
+
+        template<class TFont>
+        std::shared_ptr<TFont> Get(std::map<Key, std::weak_ptr<TFont>>& mapLoaded, const std::string& sFontFile, olc::ResourcePack* pack);
+
+    private:
+        std::map<Key, std::weak_ptr<olc::Font>>         mapFonts;
+        std::map<Key, std::weak_ptr<olc::CustomFont>>   mapCustomFonts;
+        bool                                            bKeepSprites = true;
+    };
+
+
+    template<class TFont>
+    std::shared_ptr<TFont> FontRegistry::Get(std::map<Key, std::weak_ptr<TFont>>& mapLoaded, const std::string& sFontFile, olc::ResourcePack* pack)
+    {
+        // Forget fonts nobody holds any more
+        for( auto it = mapLoaded.begin(); it != mapLoaded.end(); )
+            it = it->second.expired() ? mapLoaded.erase( it ) : std::next( it );
+
+        auto& entry = mapLoaded[ { sFontFile, pack } ];
+        std::shared_ptr<TFont> font = entry.lock();
+        if( font == nullptr )
+        {
+            // Not make_shared, which would keep the font's memory until the entry is forgotten
+            font = std::shared_ptr<TFont>( new TFont( sFontFile, pack ) );
+            if( !bKeepSprites )
+                font->ReleaseSprites();
+            entry = font;
+        }
+        return font;
+    }
+}
+
+
+#ifdef OLC_PGEX_FONTREGISTRY
+#undef OLC_PGEX_FONTREGISTRY
+
+namespace olc
+{
+    FontRegistry::FontRegistry(bool bKeepSprites) : bKeepSprites( bKeepSprites )
+    {
+    }
+
+
+    std::shared_ptr<olc::Font> FontRegistry::GetFont(const std::string& sFontFile, olc::ResourcePack* pack)
+    {
+        return Get( mapFonts, sFontFile, pack );
+    }
+
+
+    std::shared_ptr<olc::CustomFont> FontRegistry::GetCustomFont(const std::string& sFontFile, olc::ResourcePack* pack)
+    {
+        return Get( mapCustomFonts, sFontFile, pack );
+    }
+
+
+    std::vector<FontRegistry::FontInfo> FontRegistry::Fonts() const
+    {
+        std::vector<FontInfo> vFonts;
+        auto list = [&]( auto& mapLoaded, bool bCustom )
+        {
+            for( auto& [key, entry] : mapLoaded )
+            {
+                if( auto font = entry.lock() )
+                    vFonts.push_back( { key.first, key.second, bCustom, font.use_count() - 1, font->SpriteBytes(), font->TextureBytes() } );
+            }
+        };
+        list( mapFonts, false );
+        list( mapCustomFonts, true );
+        return vFonts;
+    }
+
+
+    size_t FontRegistry::SpriteBytes() const
+    {
+        size_t nBytes = 0;
+        for( auto& info : Fonts() )
+            nBytes += info.nSpriteBytes;
+        return nBytes;
+    }
+
+
+    size_t FontRegistry::TextureBytes() const
+    {
+        size_t nBytes = 0;
+        for( auto& info : Fonts() )
+            nBytes += info.nTextureBytes;
+        return nBytes;
+    }
+}
+
+#endif
+#endif
@@ -0,0 +1,428 @@
+#pragma once
+
+#ifndef __OLC_PGEX_TEXTBOX__
+#define __OLC_PGEX_TEXTBOX__
+
+#include <deque>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <functional>
+#include "olcPixelGameEngine.h"
+#include "olcPGEX_FontCommon.h"
+
+namespace olc
+{
+    // Text wrapped to a width - chat windows, item descriptions, dialogue. The text is kept as
+    // paragraphs (the text between newlines), each laid out by the font once and wrapped from the
+    // advances of that layout. Appending, changing or removing a paragraph only lays out that
+    // paragraph again, so a chat window appending a line at a time never re-wraps its history;
+    // changing the width, alignment or line spacing re-wraps every paragraph from its cached
+    // layout without asking the font again.
+    //
+    //     // OnUserCreate
+    //     chat = std::make_unique<olc::TextBox>( *font, 300.0f );
+    //
+    //     // OnUserUpdate
+    //     if( bNewMessage )
+    //         chat->Append( sMessage, olc::CYAN );
+    //     chat->Draw( { 10.0f, 400.0f - chat->Size().y } );
+    //
+    // Works with olc::Font and olc::CustomFont. Paragraphs outside the screen are not drawn at
+    // all. The font has to outlive the box.
+    class TextBox : public olc::PGEX
+    {
+    public:
+        template<class TFont>
+        TextBox(TFont& font, float fWidth, bool bProportional = true);
+
+        // Width lines are wrapped to, in unscaled pixels
+        void SetWidth(float fWidth);
+        float Width() const { return fWidth; }
+
+        // Where each line sits between the edges of the box: 0 left, 0.5 centred, 1 right (as
+        // TextLabel::align.x)
+        void SetAlign(float fAlign);
+
+        // Line height as a multiple of the font's
+        void SetLineSpacing(float fSpacing);
+
+        // true (the default) breaks lines between words, and only inside words longer than a
+        // line. false breaks after whichever character reaches the edge, for CJK text and the like
+        void SetWordWrap(bool bWords);
+
+        // Adds text at the end, a paragraph per line of it
+        void Append(std::string_view sText, const olc::Pixel col = olc::WHITE);
+
+        size_t Paragraphs() const { return vParagraphs.size(); }
+        void SetParagraph(size_t nParagraph, std::string_view sText, const olc::Pixel col = olc::WHITE);
+        void InsertParagraph(size_t nParagraph, std::string_view sText, const olc::Pixel col = olc::WHITE);
+        void EraseParagraphs(size_t nFirst, size_t nCount = 1);
+        void Clear();
+
+        // Lines of a paragraph once wrapped, and the size of the whole box
+        size_t Lines(size_t nParagraph);
+        olc::vi2d Size();
+
+        // Draws the box as one batch of the font, submitting anything batched with it before
+        void Draw(const olc::vf2d& pos, const olc::vf2d& scale = { 1.0f, 1.0f });
+
+        // Paragraphs laid out and wrapped by the last Size() or Draw()
+        size_t ParagraphsLaidOut() const { return nLaidOut; }
+        size_t ParagraphsWrapped() const { return nWrapped; }
+
+    private:
+        TextBox(int nFontHeight, float fWidth, bool bProportional);
+
+        struct Paragraph
+        {
+            std::string         sText;
+            olc::Pixel          col = olc::WHITE;
+            olc::TextLayout     line;           // the paragraph on one line, as the font lays it out
+            std::vector<float>  vAdvance;       // of each glyph of line
+            std::vector<uint8_t> vSpace;        // whether each glyph of line is a space
+            olc::TextLayout     wrapped;        // line broken to the width, drawn
+            bool                bLayout = true; // line has to be laid out
+            bool                bWrap = true;   // wrapped has to be rebuilt
+        };
+
+        Paragraph MakeParagraph(std::string_view sText, const olc::Pixel col) const;
+        void Changed(size_t nFirst);
+        void Rewrap();
+        void Update();
+        void LayOut(Paragraph& para);
+        void Wrap(Paragraph& para);
+        float LineHeight() const { return float( nFontHeight ) * fLineSpacing; }
+
+    private:
+        std::deque<Paragraph>       vParagraphs;
+        std::vector<float>          vHeight;            // of each paragraph once wrapped
+        std::vector<float>          vTop;               // y of each paragraph, valid before nTopsValid
+        size_t                      nTopsValid = 0;
+        size_t                      nFirstDirty = 0;    // no paragraph before this one needs laying out or wrapping
+        float                       fHeight = 0.0f;
+        int                         nFontHeight = 0;
+        float                       fWidth = 0.0f;
+        float                       fAlign = 0.0f;
+        float                       fLineSpacing = 1.0f;
+        bool                        bWords = true;
+        bool                        bProportional = true;
+        size_t                      nLaidOut = 0;
+        size_t                      nWrapped = 0;
+
+        // What is needed of the font: laying out a line, drawing a layout and telling its spaces apart
+        std::function<void(std::string_view, olc::TextLayout&, bool bProportional)>             layout;
+        std::function<void(const olc::vf2d&, const olc::TextLayout&, const olc::Pixel, const olc::vf2d&)> draw;
+        std::function<void(bool bBegin)>                                                        batch;
+        void                        (*decode)(std::string_view sText, std::vector<uint32_t>& vBuffer, std::vector<uint32_t>& vCodepoints) = nullptr;
+
+        std::vector<uint32_t>       vBuffer;
+        std::vector<uint32_t>       vCodepoints;
+    };
+
+
+    template<class TFont>
+    TextBox::TextBox(TFont& font, float fWidth, bool bProportional) : TextBox( font.GetTextSize( "" ).y, fWidth, bProportional )
+    {
+        layout = [&font]( std::string_view sText, olc::TextLayout& out, bool bProportional ) { font.LayoutText( sText, out, bProportional ); };
+        draw = [&font]( const olc::vf2d& pos, const olc::TextLayout& text, const olc::Pixel col, const olc::vf2d& scale ) { font.DrawStringDecal( pos, text, col, scale ); };
+        batch = [&font]( bool bBegin ) { if( bBegin ) font.BeginBatch(); else font.EndBatch(); };
+        decode = []( std::string_view sText, std::vector<uint32_t>& vBuffer, std::vector<uint32_t>& vCodepoints )
+        {
+            auto text = TFont::TextDecoder::Decode( sText, vBuffer );
+            vCodepoints.assign( text.begin(), text.end() );
+        };
+    }
+}
+
+
+#ifdef OLC_PGEX_TEXTBOX
+#undef OLC_PGEX_TEXTBOX
+
+namespace olc
+{
+    TextBox::TextBox(int nFontHeight, float fWidth, bool bProportional)
+        : nFontHeight( nFontHeight ), fWidth( fWidth ), bProportional( bProportional )
+    {
+    }
+
+
+    void TextBox::SetWidth(float fWidth)
+    {
+        if( this->fWidth == fWidth )
+            return;
+        this->fWidth = fWidth;
+        Rewrap();
+    }
+
+
+    void TextBox::SetAlign(float fAlign)
+    {
+        if( this->fAlign == fAlign )
+            return;
+        this->fAlign = fAlign;
+        Rewrap();
+    }
+
+
+    void TextBox::SetLineSpacing(float fSpacing)
+    {
+        if( fLineSpacing == fSpacing )
+            return;
+        fLineSpacing = fSpacing;
+        Rewrap();
+    }
+
+
+    void TextBox::SetWordWrap(bool bWords)
+    {
+        if( this->bWords == bWords )
+            return;
+        this->bWords = bWords;
+        Rewrap();
+    }
+
+
+    void TextBox::Rewrap()
+    {
+        for( auto& para : vParagraphs )
+            para.bWrap = true;
+        Changed( 0 );
+    }
+
+
+    TextBox::Paragraph TextBox::MakeParagraph(std::string_view sText, const olc::Pixel col) const
+    {
+        Paragraph para;
+        para.sText = sText;
+        para.col = col;
+        return para;
+    }
+
+
+    void TextBox::Append(std::string_view sText, const olc::Pixel col)
+    {
+        Changed( vParagraphs.size() );
+        for( size_t nStart = 0; ; )
+        {
+            size_t nEnd = std::min( sText.find( '\n', nStart ), sText.size() );
+            vParagraphs.push_back( MakeParagraph( sText.substr( nStart, nEnd - nStart ), col ) );
+            vHeight.push_back( 0.0f );
+            if( nEnd == sText.size() )
+                break;
+            nStart = nEnd + 1;
+        }
+    }
+
+
+    void TextBox::SetParagraph(size_t nParagraph, std::string_view sText, const olc::Pixel col)
+    {
+        if( nParagraph >= vParagraphs.size() )
+            return;
+        vParagraphs[nParagraph] = MakeParagraph( sText, col );
+        Changed( nParagraph );
+    }
+
+
+    void TextBox::InsertParagraph(size_t nParagraph, std::string_view sText, const olc::Pixel col)
+    {
+        nParagraph = std::min( nParagraph, vParagraphs.size() );
+        vParagraphs.insert( vParagraphs.begin() + nParagraph, MakeParagraph( sText, col ) );
+        vHeight.insert( vHeight.begin() + nParagraph, 0.0f );
+        Changed( nParagraph );
+    }
+
+
+    void TextBox::EraseParagraphs(size_t nFirst, size_t nCount)
+    {
+        if( nFirst >= vParagraphs.size() )
+            return;
+        nCount = std::min( nCount, vParagraphs.size() - nFirst );
+        vParagraphs.erase( vParagraphs.begin() + nFirst, vParagraphs.begin() + nFirst + nCount );
+        vHeight.erase( vHeight.begin() + nFirst, vHeight.begin() + nFirst + nCount );
+
+        // Nothing left needs laying out again, the paragraphs after the gap only move up
+        if( nFirstDirty > nFirst )
+            nFirstDirty = nFirstDirty >= nFirst + nCount ? nFirstDirty - nCount : nFirst;
+        nTopsValid = std::min( nTopsValid, nFirst );
+    }
+
+
+    void TextBox::Clear()
+    {
+        vParagraphs.clear();
+        vHeight.clear();
+        Changed( 0 );
+    }
+
+
+    void TextBox::Changed(size_t nFirst)
+    {
+        // Paragraphs from nFirst on may have changed, and so moved
+        nTopsValid = std::min( nTopsValid, nFirst );
+        nFirstDirty = std::min( nFirstDirty, nFirst );
+    }
+
+
+    size_t TextBox::Lines(size_t nParagraph)
+    {
+        if( nParagraph >= vParagraphs.size() )
+            return 0;
+        Update();
+        return vParagraphs[nParagraph].wrapped.vLineStarts.size();
+    }
+
+
+    olc::vi2d TextBox::Size()
+    {
+        Update();
+        return { int( std::ceil( fWidth ) ), int( std::ceil( fHeight ) ) };
+    }
+
+
+    void TextBox::Update()
+    {
+        nLaidOut = 0;
+        nWrapped = 0;
+        for( size_t i = nFirstDirty; i < vParagraphs.size(); i++ )
+        {
+            Paragraph& para = vParagraphs[i];
+            if( para.bLayout )
+                LayOut( para );
+            if( para.bWrap )
+            {
+                Wrap( para );
+                vHeight[i] = float( para.wrapped.size.y );
+            }
+        }
+        nFirstDirty = vParagraphs.size();
+
+        // Only the paragraphs after a change move
+        vTop.resize( vParagraphs.size() );
+        float y = nTopsValid == 0 ? 0.0f : vTop[nTopsValid - 1] + vHeight[nTopsValid - 1];
+        for( size_t i = nTopsValid; i < vParagraphs.size(); i++ )
+        {
+            vTop[i] = y;
+            y += vHeight[i];
+        }
+        nTopsValid = vParagraphs.size();
+        fHeight = vParagraphs.empty() ? 0.0f : vTop.back() + vHeight.back();
+    }
+
+
+    void TextBox::LayOut(Paragraph& para)
+    {
+        layout( para.sText, para.line, bProportional );
+
+        // The advance of a glyph is how far the next one is from it
+        const size_t nGlyphs = para.line.vGlyphs.size();
+        para.vAdvance.resize( nGlyphs );
+        for( size_t i = 0; i < nGlyphs; i++ )
+        {
+            float fNext = i + 1 < nGlyphs ? para.line.vGlyphs[i + 1].offset.x : float( para.line.size.x );
+            para.vAdvance[i] = fNext - para.line.vGlyphs[i].offset.x;
+        }
+
+        decode( para.sText, vBuffer, vCodepoints );
+        para.vSpace.resize( nGlyphs );
+        for( size_t i = 0; i < nGlyphs; i++ )
+            para.vSpace[i] = i < vCodepoints.size() && ( vCodepoints[i] == ' ' || vCodepoints[i] == '\t' );
+
+        para.bLayout = false;
+        para.bWrap = true;
+        nLaidOut++;
+    }
+
+
+    void TextBox::Wrap(Paragraph& para)
+    {
+        const auto& vGlyphs = para.line.vGlyphs;
+        const size_t nGlyphs = vGlyphs.size();
+        const float fLineHeight = LineHeight();
+
+        olc::TextLayout& out = para.wrapped;
+        out.Clear();
+        out.bProportional = bProportional;
+        out.vGlyphs.reserve( nGlyphs );
+
+        // Finds where each line ends, then copies its glyphs across moved to their line
+        size_t nStart = 0;
+        float fRight = 0.0f;
+        do
+        {
+            // Spaces hang past the edge, so a line is full at the first other glyph crossing it
+            const float x0 = nStart < nGlyphs ? vGlyphs[nStart].offset.x : 0.0f;
+            size_t nEnd = nStart, nWordStart = nStart;
+            for( ; nEnd < nGlyphs; nEnd++ )
+            {
+                if( para.vSpace[nEnd] )
+                    continue;
+                if( nEnd > nStart && para.vSpace[nEnd - 1] )
+                    nWordStart = nEnd;
+                if( nEnd > nStart && vGlyphs[nEnd].offset.x + para.vAdvance[nEnd] - x0 > fWidth )
+                    break;
+            }
+            if( nEnd < nGlyphs && bWords && nWordStart > nStart )
+                nEnd = nWordStart;
+
+            // Width of the line without its trailing spaces
+            size_t nLast = nEnd;
+            while( nLast > nStart && para.vSpace[nLast - 1] )
+                nLast--;
+            const float fLineWidth = nLast > nStart ? vGlyphs[nLast - 1].offset.x + para.vAdvance[nLast - 1] - x0 : 0.0f;
+            const float fShift = std::floor( fAlign * std::max( fWidth - fLineWidth, 0.0f ) );
+
+            const float y = float( out.vLineStarts.size() ) * fLineHeight;
+            out.vLineStarts.push_back( out.vGlyphs.size() );
+            for( size_t i = nStart; i < nLast; i++ )
+            {
+                out.vGlyphs.push_back( vGlyphs[i] );
+                out.vGlyphs.back().offset = { vGlyphs[i].offset.x - x0 + fShift, y };
+            }
+            fRight = std::max( fRight, fShift + fLineWidth );
+
+            // The next line starts at its first word, the spaces before it are dropped
+            nStart = nEnd;
+            while( nStart < nGlyphs && para.vSpace[nStart] )
+                nStart++;
+        }
+        while( nStart < nGlyphs );
+
+        out.size = { int( std::ceil( fRight ) ), int( std::ceil( float( out.vLineStarts.size() ) * fLineHeight ) ) };
+        para.bWrap = false;
+        nWrapped++;
+    }
+
+
+    void TextBox::Draw(const olc::vf2d& pos, const olc::vf2d& scale)
+    {
+        Update();
+        if( vParagraphs.empty() )
+            return;
+
+        // Start at the first paragraph reaching the top of the screen, stop below the bottom
+        const float fScreenHeight = float( pge->ScreenHeight() );
+        size_t i = 0;
+        if( scale.y > 0.0f )
+        {
+            auto it = std::upper_bound( vTop.begin(), vTop.end(), -pos.y / scale.y );
+            i = it == vTop.begin() ? 0 : size_t( it - vTop.begin() ) - 1;
+        }
+
+        batch( true );
+        for( ; i < vParagraphs.size(); i++ )
+        {
+            const float y = pos.y + vTop[i] * scale.y;
+            if( scale.y > 0.0f && y >= fScreenHeight )
+                break;
+            draw( { pos.x, y }, vParagraphs[i].wrapped, vParagraphs[i].col, scale );
+        }
+        batch( false );
+    }
+}
+
+#endif
+#endif
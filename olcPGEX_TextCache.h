@@ -0,0 +1,282 @@
+#pragma once
+
+#ifndef __OLC_PGEX_TEXTCACHE__
+#define __OLC_PGEX_TEXTCACHE__
+
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <unordered_map>
+#include "olcPixelGameEngine.h"
+#include "olcPGEX_FontCommon.h"
+
+namespace olc
+{
+    // Draws static strings (menu items, tooltips, labels...) as a single quad each. The first time a
+    // string is drawn with a font it is rendered once into its own sprite/decal, every following draw
+    // reuses that decal. Baked strings are white and get their colour and scale from the decal tint
+    // and scale, so one bake serves every colour and size the string is drawn at.
+    // Least recently used strings are thrown away once the baked pixels exceed the memory budget.
+    //
+    // TextCache hooks into the engine to release evicted decals once the frame that drew them has
+    // been rendered, so create it once the engine is running (OnUserCreate) and keep it for the
+    // lifetime of the engine.
+    //
+    // Strings are baked with the software renderer, so the fonts drawn through the cache must
+    // keep their sprites: don't call ReleaseSprites() on them. Entries are keyed on the font's
+    // GetId(), so a font destroyed and another created at the same address never share strings;
+    // the dead font's strings simply age out, or ReleaseFont() drops them straight away.
+    class TextCache : public olc::PGEX
+    {
+    public:
+        struct Stats
+        {
+            uint64_t    nHits       = 0;
+            uint64_t    nMisses     = 0;
+            uint64_t    nEvictions  = 0;
+            size_t      nEntries    = 0;
+            size_t      nBytes      = 0;    // pixel data held by the cached sprites and their decals
+        };
+
+    public:
+        TextCache(size_t nBudgetBytes = 16 * 1024 * 1024);
+
+        template<class TFont> void DrawStringDecal(TFont& font, const olc::vf2d& pos, std::string_view sText, const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
+        template<class TFont> void DrawStringPropDecal(TFont& font, const olc::vf2d& pos, std::string_view sText, const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
+        template<class TFont> void DrawRotatedStringDecal(TFont& font, const olc::vf2d& pos, std::string_view sText, const float fAngle, const olc::vf2d& center = { 0.0f, 0.0f },
+                                                          const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
+        template<class TFont> void DrawRotatedStringPropDecal(TFont& font, const olc::vf2d& pos, std::string_view sText, const float fAngle, const olc::vf2d& center = { 0.0f, 0.0f },
+                                                              const Pixel col = olc::WHITE, const olc::vf2d& scale = { 1.0f, 1.0f });
+
+        void SetBudget(size_t nBudgetBytes);
+        void Clear();
+
+        // Drops every string baked with the font, eg. just before the font is destroyed
+        template<class TFont> void ReleaseFont(const TFont& font);
+
+        const Stats& GetStats() const;
+        void ResetStats();
+
+    protected:
+        bool OnBeforeUserUpdate(float& fElapsedTime) override;
+
+    private:
+        struct Entry
+        {
+            uint64_t                        nFontId = 0;
+            bool                            bProportional = true;
+            std::string                     sText;
+            uint64_t                        nHash = 0;
+            size_t                          nBytes = 0;
+            std::unique_ptr<olc::Sprite>    sprite;
+            std::unique_ptr<olc::Decal>     decal;
+        };
+
+        template<class TFont> olc::Decal* Fetch(TFont& font, std::string_view sText, bool bProportional);
+
+        static uint64_t Hash(uint64_t nFontId, std::string_view sText, bool bProportional);
+        Entry* Find(uint64_t nFontId, std::string_view sText, bool bProportional, uint64_t nHash);
+        void EraseFont(uint64_t nFontId);
+        olc::Decal* Insert(Entry&& entry);
+        void Erase(std::list<Entry>::iterator it);
+        void Trim();
+
+    private:
+        size_t                                                  nBudget;
+        Stats                                                   stats;
+        std::list<Entry>                                        lEntries;       // most recently used first
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> mEntries;
+        std::list<Entry>                                        lReleased;      // evicted this frame, possibly still referenced by the frame's decal instances
+        olc::TextLayout                                         layout;
+    };
+
+
+    template<class TFont>
+    olc::Decal* TextCache::Fetch(TFont& font, std::string_view sText, bool bProportional)
+    {
+        uint64_t nFontId = font.GetId();
+        uint64_t nHash = Hash( nFontId, sText, bProportional );
+        if( Entry* entry = Find( nFontId, sText, bProportional, nHash ) )
+        {
+            stats.nHits++;
+            return entry->decal.get();
+        }
+
+        stats.nMisses++;
+        font.LayoutText( sText, layout, bProportional );
+
+        Entry entry;
+        entry.nFontId       = nFontId;
+        entry.bProportional = bProportional;
+        entry.sText         = sText;
+        entry.nHash         = nHash;
+        entry.sprite        = std::make_unique<olc::Sprite>( std::max( layout.size.x, 1 ), std::max( layout.size.y, 1 ) );
+        entry.nBytes        = size_t( entry.sprite->width ) * size_t( entry.sprite->height ) * sizeof( olc::Pixel ) * 2;
+        for( int i = 0; i < entry.sprite->width * entry.sprite->height; i++ )
+            entry.sprite->GetData()[i] = olc::BLANK;
+        font.DrawString( entry.sprite.get(), { 0, 0 }, layout, olc::WHITE, 1 );
+        entry.decal         = std::make_unique<olc::Decal>( entry.sprite.get() );
+        return Insert( std::move( entry ) );
+    }
+
+
+    template<class TFont>
+    void TextCache::ReleaseFont(const TFont& font)
+    {
+        EraseFont( font.GetId() );
+    }
+
+
+    template<class TFont>
+    void TextCache::DrawStringDecal(TFont& font, const olc::vf2d& pos, std::string_view sText, const Pixel col, const olc::vf2d& scale)
+    {
+        pge->DrawDecal( pos, Fetch( font, sText, false ), scale, col );
+    }
+
+
+    template<class TFont>
+    void TextCache::DrawStringPropDecal(TFont& font, const olc::vf2d& pos, std::string_view sText, const Pixel col, const olc::vf2d& scale)
+    {
+        pge->DrawDecal( pos, Fetch( font, sText, true ), scale, col );
+    }
+
+
+    template<class TFont>
+    void TextCache::DrawRotatedStringDecal(TFont& font, const olc::vf2d& pos, std::string_view sText, const float fAngle, const olc::vf2d& center, const Pixel col, const olc::vf2d& scale)
+    {
+        pge->DrawRotatedDecal( pos, Fetch( font, sText, false ), fAngle, center, scale, col );
+    }
+
+
+    template<class TFont>
+    void TextCache::DrawRotatedStringPropDecal(TFont& font, const olc::vf2d& pos, std::string_view sText, const float fAngle, const olc::vf2d& center, const Pixel col, const olc::vf2d& scale)
+    {
+        pge->DrawRotatedDecal( pos, Fetch( font, sText, true ), fAngle, center, scale, col );
+    }
+}
+
+
+#ifdef OLC_PGEX_TEXTCACHE
+#undef OLC_PGEX_TEXTCACHE
+
+namespace olc
+{
+    TextCache::TextCache(size_t nBudgetBytes) : olc::PGEX(true), nBudget(nBudgetBytes)
+    {
+    }
+
+
+    uint64_t TextCache::Hash(uint64_t nFontId, std::string_view sText, bool bProportional)
+    {
+        // FNV-1a over the font, the spacing mode and the text
+        uint64_t h = ( 0xcbf29ce484222325ull ^ nFontId ) * 0x100000001b3ull;
+        h = ( h ^ uint64_t( bProportional ) ) * 0x100000001b3ull;
+        for( auto c : sText )
+            h = ( h ^ uint8_t( c ) ) * 0x100000001b3ull;
+        return h;
+    }
+
+
+    TextCache::Entry* TextCache::Find(uint64_t nFontId, std::string_view sText, bool bProportional, uint64_t nHash)
+    {
+        auto it = mEntries.find( nHash );
+        if( it == mEntries.end() )
+            return nullptr;
+
+        auto entry = it->second;
+        if( entry->nFontId != nFontId || entry->bProportional != bProportional || entry->sText != sText )
+            return nullptr;
+
+        // Move to the front of the recently used list
+        lEntries.splice( lEntries.begin(), lEntries, entry );
+        return &*entry;
+    }
+
+
+    olc::Decal* TextCache::Insert(Entry&& entry)
+    {
+        // A different string with the same hash makes way for the new one
+        auto it = mEntries.find( entry.nHash );
+        if( it != mEntries.end() )
+            Erase( it->second );
+
+        stats.nBytes += entry.nBytes;
+        lEntries.push_front( std::move( entry ) );
+        mEntries[ lEntries.front().nHash ] = lEntries.begin();
+        olc::Decal* decal = lEntries.front().decal.get();
+        Trim();
+        stats.nEntries = lEntries.size();
+        return decal;
+    }
+
+
+    void TextCache::Erase(std::list<Entry>::iterator it)
+    {
+        stats.nBytes -= it->nBytes;
+        mEntries.erase( it->nHash );
+        lReleased.splice( lReleased.end(), lEntries, it );
+        stats.nEntries = lEntries.size();
+    }
+
+
+    void TextCache::Trim()
+    {
+        // Always keep the most recent string, even if it alone is over budget
+        while( stats.nBytes > nBudget && lEntries.size() > 1 )
+        {
+            Erase( std::prev( lEntries.end() ) );
+            stats.nEvictions++;
+        }
+    }
+
+
+    void TextCache::SetBudget(size_t nBudgetBytes)
+    {
+        nBudget = nBudgetBytes;
+        Trim();
+    }
+
+
+    void TextCache::Clear()
+    {
+        while( !lEntries.empty() )
+            Erase( lEntries.begin() );
+    }
+
+
+    void TextCache::EraseFont(uint64_t nFontId)
+    {
+        for( auto it = lEntries.begin(); it != lEntries.end(); )
+        {
+            auto next = std::next( it );
+            if( it->nFontId == nFontId )
+                Erase( it );
+            it = next;
+        }
+    }
+
+
+    const TextCache::Stats& TextCache::GetStats() const
+    {
+        return stats;
+    }
+
+
+    void TextCache::ResetStats()
+    {
+        stats.nHits = stats.nMisses = stats.nEvictions = 0;
+    }
+
+
+    bool TextCache::OnBeforeUserUpdate(float&)
+    {
+        // The previous frame has been rendered, nothing refers to the evicted decals any more
+        lReleased.clear();
+        return false;
+    }
+}
+
+#endif
+#endif
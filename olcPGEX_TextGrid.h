@@ -0,0 +1,305 @@
+#pragma once
+
+#ifndef __OLC_PGEX_TEXTGRID__
+#define __OLC_PGEX_TEXTGRID__
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <functional>
+#include "olcPixelGameEngine.h"
+#include "olcPGEX_FontCommon.h"
+
+namespace olc
+{
+    // A fixed grid of monospaced characters - a console, a terminal, a log view - kept rendered
+    // in sprites instead of being laid out again every frame. Each cell holds a character and a
+    // colour. Changing a cell marks its row dirty; Draw() software renders the dirty rows into
+    // their band (a sprite and decal of nBandRows rows), uploads the bands that changed and draws
+    // the whole grid as a few quads, one or two per band.
+    //
+    // Scroll() moves the rows rather than the text in them: the grid is a ring of rows and only
+    // the rows scrolled in are cleared and rendered, so a log scrolling a line a frame re-renders
+    // one row per frame.
+    //
+    //     // OnUserCreate
+    //     console = std::make_unique<olc::TextGrid>( *font, 80, 50 );
+    //
+    //     // OnUserUpdate
+    //     console->PushLine( "> ready", olc::GREEN );
+    //     console->Draw( { 0, 0 } );
+    //
+    // The grid creates decals, so create it once the engine is running. The font has to outlive it
+    // and keep its sprites, which the rows are rendered from - don't call ReleaseSprites() on it.
+    class TextGrid : public olc::PGEX
+    {
+    public:
+        template<class TFont>
+        TextGrid(TFont& font, int nCols, int nRows, int nBandRows = 8);
+
+        int Cols() const { return nCols; }
+        int Rows() const { return nRows; }
+        const olc::vi2d& CellSize() const { return vCellSize; }
+
+        // Cells are addressed as shown, row 0 at the top. Out of range cells are ignored
+        void Set(int x, int y, uint32_t c, const olc::Pixel col = olc::WHITE);
+        uint32_t Get(int x, int y) const;
+
+        // Writes text from (x, y) on, in the encoding of the font. A newline continues at x on
+        // the next row, text past the right edge is cut off
+        void Print(int x, int y, std::string_view sText, const olc::Pixel col = olc::WHITE);
+
+        // Scrolls everything up a row and prints the text on the bottom row
+        void PushLine(std::string_view sText, const olc::Pixel col = olc::WHITE);
+
+        // Moves the text up by nLines rows (down when negative), clearing the rows that come in
+        void Scroll(int nLines);
+
+        void ClearRow(int y);
+        void Clear();
+
+        // Renders the dirty rows and uploads the bands they are in. Draw() calls it
+        void Update();
+        void Draw(const olc::vf2d& pos, const olc::vf2d& scale = { 1.0f, 1.0f }, const olc::Pixel tint = olc::WHITE);
+
+        // Rows rendered by the last Update()
+        int RowsRendered() const { return nRowsRendered; }
+
+    private:
+        TextGrid(const olc::vi2d& vCellSize, int nCols, int nRows, int nBandRows);
+
+        int Physical(int y) const { return ( nTop + y ) % nRows; }
+        void RenderRow(int nRow);
+
+    private:
+        struct Cell
+        {
+            uint32_t    c = 0;
+            olc::Pixel  col = olc::WHITE;
+        };
+
+        struct Band
+        {
+            std::unique_ptr<olc::Sprite>    sprite;
+            std::unique_ptr<olc::Decal>     decal;
+        };
+
+        typedef void (*DecodeFunc)(std::string_view sText, std::vector<uint32_t>& vBuffer, std::vector<uint32_t>& vCodepoints);
+
+        olc::vi2d                   vCellSize;
+        int                         nCols;
+        int                         nRows;
+        int                         nBandRows;
+        int                         nTop = 0;           // physical row shown at the top
+        int                         nRowsRendered = 0;
+        std::vector<Cell>           vCells;             // by physical row
+        std::vector<uint8_t>        vDirty;             // by physical row
+        std::vector<Band>           vBands;
+
+        // What is needed of the font: drawing a string into a sprite, and its text encoding
+        std::function<void(olc::Sprite*, const olc::vi2d&, std::string_view, const olc::Pixel)>    drawRun;
+        void                        (*encode)(uint32_t c, std::string& s) = nullptr;
+        DecodeFunc                  decode = nullptr;
+
+        std::string                 sRun;
+        std::vector<uint32_t>       vBuffer;
+        std::vector<uint32_t>       vCodepoints;
+    };
+
+
+    template<class TFont>
+    TextGrid::TextGrid(TFont& font, int nCols, int nRows, int nBandRows) : TextGrid( font.GetTextSize( "W" ), nCols, nRows, nBandRows )
+    {
+        drawRun = [&font]( olc::Sprite* target, const olc::vi2d& pos, std::string_view sText, const olc::Pixel col ) { font.DrawString( target, pos, sText, col ); };
+        encode = &TFont::TextDecoder::Encode;
+        decode = []( std::string_view sText, std::vector<uint32_t>& vBuffer, std::vector<uint32_t>& vCodepoints )
+        {
+            auto text = TFont::TextDecoder::Decode( sText, vBuffer );
+            vCodepoints.assign( text.begin(), text.end() );
+        };
+    }
+}
+
+
+#ifdef OLC_PGEX_TEXTGRID
+#undef OLC_PGEX_TEXTGRID
+
+namespace olc
+{
+    TextGrid::TextGrid(const olc::vi2d& vCellSize, int nCols, int nRows, int nBandRows)
+        : vCellSize( vCellSize ), nCols( std::max( nCols, 1 ) ), nRows( std::max( nRows, 1 ) ), nBandRows( std::max( nBandRows, 1 ) )
+    {
+        vCells.resize( size_t( this->nCols ) * size_t( this->nRows ) );
+        vDirty.assign( size_t( this->nRows ), 0 );
+        for( int y = 0; y < this->nRows; y += this->nBandRows )
+        {
+            int nBand = std::min( this->nBandRows, this->nRows - y );
+            Band band;
+            band.sprite = std::make_unique<olc::Sprite>( this->nCols * vCellSize.x, nBand * vCellSize.y );
+            for( int i = 0; i < band.sprite->width * band.sprite->height; i++ )
+                band.sprite->GetData()[i] = olc::BLANK;
+            band.decal = std::make_unique<olc::Decal>( band.sprite.get() );
+            vBands.push_back( std::move( band ) );
+        }
+    }
+
+
+    void TextGrid::Set(int x, int y, uint32_t c, const olc::Pixel col)
+    {
+        if( x < 0 || x >= nCols || y < 0 || y >= nRows )
+            return;
+
+        int nRow = Physical( y );
+        Cell& cell = vCells[size_t( nRow ) * nCols + x];
+        if( cell.c == c && cell.col == col )
+            return;
+        cell.c = c;
+        cell.col = col;
+        vDirty[nRow] = 1;
+    }
+
+
+    uint32_t TextGrid::Get(int x, int y) const
+    {
+        if( x < 0 || x >= nCols || y < 0 || y >= nRows )
+            return 0;
+        return vCells[size_t( Physical( y ) ) * nCols + x].c;
+    }
+
+
+    void TextGrid::Print(int x, int y, std::string_view sText, const olc::Pixel col)
+    {
+        decode( sText, vBuffer, vCodepoints );
+        int cx = x;
+        for( auto c : vCodepoints )
+        {
+            if( c == '\n' )
+            {
+                cx = x;
+                if( ++y >= nRows )
+                    break;
+            }
+            else
+                Set( cx++, y, c, col );
+        }
+    }
+
+
+    void TextGrid::PushLine(std::string_view sText, const olc::Pixel col)
+    {
+        Scroll( 1 );
+        Print( 0, nRows - 1, sText, col );
+    }
+
+
+    void TextGrid::Scroll(int nLines)
+    {
+        if( nLines >= nRows || -nLines >= nRows )
+        {
+            Clear();
+            return;
+        }
+
+        // Move the top of the ring, then clear the rows that wrapped round to the other end
+        nTop = ( nTop + nLines % nRows + nRows ) % nRows;
+        if( nLines > 0 )
+            for( int y = nRows - nLines; y < nRows; y++ )
+                ClearRow( y );
+        else
+            for( int y = 0; y < -nLines; y++ )
+                ClearRow( y );
+    }
+
+
+    void TextGrid::ClearRow(int y)
+    {
+        if( y < 0 || y >= nRows )
+            return;
+        int nRow = Physical( y );
+        for( int x = 0; x < nCols; x++ )
+            vCells[size_t( nRow ) * nCols + x] = Cell();
+        vDirty[nRow] = 1;
+    }
+
+
+    void TextGrid::Clear()
+    {
+        for( int y = 0; y < nRows; y++ )
+            ClearRow( y );
+    }
+
+
+    void TextGrid::RenderRow(int nRow)
+    {
+        Band& band = vBands[nRow / nBandRows];
+        int y0 = ( nRow % nBandRows ) * vCellSize.y;
+        olc::Pixel* pRow = band.sprite->GetData() + size_t( y0 ) * band.sprite->width;
+        std::fill( pRow, pRow + size_t( vCellSize.y ) * band.sprite->width, olc::BLANK );
+
+        // One string per run of cells of the same colour. Empty cells (and control characters,
+        // which would upset the layout) end a run and are skipped
+        const Cell* cells = &vCells[size_t( nRow ) * nCols];
+        auto empty = []( const Cell& cell ) { return cell.c < ' '; };
+        for( int x = 0; x < nCols; )
+        {
+            if( empty( cells[x] ) )
+            {
+                x++;
+                continue;
+            }
+
+            int x0 = x;
+            sRun.clear();
+            for( ; x < nCols && !empty( cells[x] ) && cells[x].col == cells[x0].col; x++ )
+                encode( cells[x].c, sRun );
+            drawRun( band.sprite.get(), { x0 * vCellSize.x, y0 }, sRun, cells[x0].col );
+        }
+        vDirty[nRow] = 0;
+    }
+
+
+    void TextGrid::Update()
+    {
+        nRowsRendered = 0;
+        for( size_t b = 0; b < vBands.size(); b++ )
+        {
+            int nFirst = int( b ) * nBandRows;
+            int nLast = std::min( nFirst + nBandRows, nRows );
+            bool bChanged = false;
+            for( int nRow = nFirst; nRow < nLast; nRow++ )
+            {
+                if( vDirty[nRow] )
+                {
+                    RenderRow( nRow );
+                    nRowsRendered++;
+                    bChanged = true;
+                }
+            }
+            if( bChanged )
+                vBands[b].decal->Update();
+        }
+    }
+
+
+    void TextGrid::Draw(const olc::vf2d& pos, const olc::vf2d& scale, const olc::Pixel tint)
+    {
+        Update();
+
+        // Walk the rows top to bottom, one quad per stretch of rows that are next to each other in a band
+        for( int y = 0; y < nRows; )
+        {
+            int nRow = Physical( y );
+            int nBand = nRow / nBandRows;
+            int nCount = std::min( std::min( ( nBand + 1 ) * nBandRows, nRows ) - nRow, nRows - y );
+            olc::vf2d source = { 0.0f, float( ( nRow - nBand * nBandRows ) * vCellSize.y ) };
+            olc::vf2d size = { float( nCols * vCellSize.x ), float( nCount * vCellSize.y ) };
+            pge->DrawPartialDecal( pos + olc::vf2d( 0.0f, float( y * vCellSize.y ) ) * scale, vBands[nBand].decal.get(), source, size, scale, tint );
+            y += nCount;
+        }
+    }
+}
+
+#endif
+#endif
@@ -0,0 +1,694 @@
+#pragma once
+
+#ifndef __OLC_PGEX_TRUETYPE__
+#define __OLC_PGEX_TRUETYPE__
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+
+// Reads truetype fonts and rasterises their glyphs, for olc::DynamicFont and the font_baker tool:
+// the font's metrics, codepoint to glyph lookup and antialiased glyph bitmaps. Fonts with truetype
+// outlines (the 'glyf' table - .ttf files, .otf files holding truetype outlines and .ttc
+// collections of them) are read; fonts with CFF outlines are rejected by InitFont().
+//
+// Every read is checked against the size of the font data, so a truncated or malformed file makes
+// glyphs go missing or come out wrong but never reads outside the buffer. Composite glyphs are
+// followed 8 levels deep at most, and a glyph stops being outlined after MAX_EDGES line segments.
+//
+// Coverage is the exact area of each pixel inside the outline (nonzero winding), computed from the
+// outline flattened to line segments no more than a fifth of a pixel off its curves.
+//
+// Licensed as the rest of this repository, see the OLC-3 licence in README.md.
+
+namespace olc::font::ttf
+{
+    // The font data, every read bounds checked - out of range reads give 0
+    struct Bytes
+    {
+        const uint8_t*  pData = nullptr;
+        size_t          nSize = 0;
+
+        bool     Has( size_t nOffset, size_t nBytes ) const { return nOffset <= nSize && nSize - nOffset >= nBytes; }
+        uint8_t  U8( size_t nOffset ) const  { return Has( nOffset, 1 ) ? pData[nOffset] : 0; }
+        uint16_t U16( size_t nOffset ) const { return Has( nOffset, 2 ) ? uint16_t( pData[nOffset] << 8 | pData[nOffset + 1] ) : 0; }
+        int16_t  S16( size_t nOffset ) const { return int16_t( U16( nOffset ) ); }
+        uint32_t U32( size_t nOffset ) const
+        {
+            return Has( nOffset, 4 ) ? uint32_t( pData[nOffset] ) << 24 | uint32_t( pData[nOffset + 1] ) << 16 | uint32_t( pData[nOffset + 2] ) << 8 | pData[nOffset + 3] : 0;
+        }
+        bool Tag( size_t nOffset, const char* sTag ) const
+        {
+            return Has( nOffset, 4 ) && pData[nOffset] == uint8_t( sTag[0] ) && pData[nOffset + 1] == uint8_t( sTag[1] ) &&
+                   pData[nOffset + 2] == uint8_t( sTag[2] ) && pData[nOffset + 3] == uint8_t( sTag[3] );
+        }
+    };
+
+    // Where the tables of one font are. Filled in by InitFont(), only read afterwards. The font
+    // data is not copied and has to outlive it
+    struct FontInfo
+    {
+        Bytes       bytes;
+        size_t      nLoca = 0, nHead = 0, nGlyf = 0, nHhea = 0, nHmtx = 0;     // table offsets
+        size_t      nGlyfEnd = 0;
+        size_t      nIndexMap = 0;          // the cmap subtable used for lookups
+        int         nGlyphs = 0;
+        int         nLocaFormat = 0;        // short or long 'loca' offsets
+    };
+
+    // A glyph is no longer outlined past this many line segments
+    constexpr int MAX_EDGES = 1 << 18;
+
+    // Offset of the nIndex'th font in a file, -1 if there is no such font. Plain font files hold
+    // font 0 only, collections (.ttc) any number
+    inline int GetFontOffsetForIndex( const uint8_t* pData, size_t nSize, int nIndex );
+
+    // Finds the tables of the font at nOffset in pData. Returns false if it isn't a font with
+    // truetype outlines or its tables don't fit in the data
+    inline bool InitFont( FontInfo& info, const uint8_t* pData, size_t nSize, int nOffset );
+
+    // Scale making the font's ascent to descent span fPixels
+    inline float ScaleForPixelHeight( const FontInfo& info, float fPixels );
+
+    // Scale making one em span fPixels, as the point size of most other software
+    inline float ScaleForMappingEmToPixels( const FontInfo& info, float fPixels );
+
+    // In unscaled font units: ascent above the baseline (positive), descent below it (negative)
+    // and the gap between one line's descent and the next line's ascent
+    inline void GetFontVMetrics( const FontInfo& info, int& nAscent, int& nDescent, int& nLineGap );
+
+    // Box around every glyph of the font, in unscaled font units, y up
+    inline void GetFontBoundingBox( const FontInfo& info, int& x0, int& y0, int& x1, int& y1 );
+
+    // Glyph of a unicode codepoint, 0 (the missing glyph) if the font doesn't have one
+    inline int FindGlyphIndex( const FontInfo& info, uint32_t nCodepoint );
+
+    // Pen advance and left side bearing of a glyph, in unscaled font units
+    inline void GetGlyphHMetrics( const FontInfo& info, int nGlyph, int& nAdvance, int& nBearing );
+
+    // Pixel box the scaled glyph covers, relative to the pen position on the baseline, y down.
+    // All zero for glyphs without an outline
+    inline void GetGlyphBitmapBox( const FontInfo& info, int nGlyph, float fScaleX, float fScaleY, int& x0, int& y0, int& x1, int& y1 );
+
+    // Renders the coverage of a glyph into a w x h bitmap whose top left is the top left of its
+    // GetGlyphBitmapBox(), nStride bytes per row
+    inline void MakeGlyphBitmap( const FontInfo& info, uint8_t* pOutput, int w, int h, int nStride, float fScaleX, float fScaleY, int nGlyph );
+
+
+    namespace detail
+    {
+        // The line segments of an outline in bitmap pixels, collected for the rasteriser
+        struct Edge
+        {
+            float x0, y0, x1, y1;
+        };
+
+        // Component transform, font units: x' = a x + c y + e, y' = b x + d y + f
+        struct Matrix
+        {
+            float a = 1.0f, b = 0.0f, c = 0.0f, d = 1.0f, e = 0.0f, f = 0.0f;
+        };
+
+        struct Outline
+        {
+            std::vector<Edge>   vEdges;
+            bool                bFull = false;      // MAX_EDGES reached
+            int                 nComponents = 0;    // composite components followed so far
+
+            // Font units to bitmap pixels: x * sx + ox, y * sy + oy (sy negative, as y points down)
+            float               sx = 1.0f, sy = -1.0f, ox = 0.0f, oy = 0.0f;
+
+            // Pen position, in font units
+            float               px = 0.0f, py = 0.0f;
+        };
+
+        struct Point
+        {
+            float   x = 0.0f, y = 0.0f;
+            uint8_t flags = 0;
+        };
+
+        inline bool IsFont( const Bytes& bytes, size_t nOffset )
+        {
+            // truetype 1.0, apple 'true', opentype with truetype or CFF outlines
+            return ( bytes.Has( nOffset, 4 ) && bytes.U32( nOffset ) == 0x00010000 ) || bytes.Tag( nOffset, "true" ) ||
+                   bytes.Tag( nOffset, "OTTO" ) || bytes.Tag( nOffset, "typ1" );
+        }
+
+        // Offset of a table of the font at nFontStart, 0 if it has none or it doesn't fit in the data
+        inline size_t FindTable( const Bytes& bytes, size_t nFontStart, const char* sTag, size_t* pLength = nullptr )
+        {
+            const int nTables = bytes.U16( nFontStart + 4 );
+            for( int i = 0; i < nTables; i++ )
+            {
+                const size_t nRecord = nFontStart + 12 + 16 * size_t( i );
+                if( !bytes.Tag( nRecord, sTag ) )
+                    continue;
+                const size_t nOffset = bytes.U32( nRecord + 8 ), nLength = bytes.U32( nRecord + 12 );
+                if( nOffset == 0 || !bytes.Has( nOffset, nLength ) )
+                    return 0;
+                if( pLength != nullptr )
+                    *pLength = nLength;
+                return nOffset;
+            }
+            return 0;
+        }
+
+        // Where a glyph's outline is in the font, false if it has none (a space) or it is out of range
+        inline bool GlyphRange( const FontInfo& info, int nGlyph, size_t& nStart, size_t& nEnd )
+        {
+            if( nGlyph < 0 || nGlyph >= info.nGlyphs )
+                return false;
+            if( info.nLocaFormat == 0 )
+            {
+                nStart = info.nGlyf + size_t( info.bytes.U16( info.nLoca + size_t( nGlyph ) * 2 ) ) * 2;
+                nEnd   = info.nGlyf + size_t( info.bytes.U16( info.nLoca + size_t( nGlyph ) * 2 + 2 ) ) * 2;
+            }
+            else
+            {
+                nStart = info.nGlyf + info.bytes.U32( info.nLoca + size_t( nGlyph ) * 4 );
+                nEnd   = info.nGlyf + info.bytes.U32( info.nLoca + size_t( nGlyph ) * 4 + 4 );
+            }
+            // At least the glyph header, inside the glyf table
+            return nStart + 10 <= nEnd && nEnd <= info.nGlyfEnd;
+        }
+
+        inline void AddEdge( Outline& out, float x0, float y0, float x1, float y1 )
+        {
+            if( y0 == y1 || out.bFull || !std::isfinite( x0 ) || !std::isfinite( y0 ) || !std::isfinite( x1 ) || !std::isfinite( y1 ) )
+                return;
+            if( out.vEdges.size() >= size_t( MAX_EDGES ) )
+            {
+                out.bFull = true;
+                return;
+            }
+            out.vEdges.push_back( { x0, y0, x1, y1 } );
+        }
+
+        inline void LineTo( Outline& out, const Matrix& m, float x, float y )
+        {
+            const float x0 = ( m.a * out.px + m.c * out.py + m.e ) * out.sx + out.ox;
+            const float y0 = ( m.b * out.px + m.d * out.py + m.f ) * out.sy + out.oy;
+            const float x1 = ( m.a * x + m.c * y + m.e ) * out.sx + out.ox;
+            const float y1 = ( m.b * x + m.d * y + m.f ) * out.sy + out.oy;
+            AddEdge( out, x0, y0, x1, y1 );
+            out.px = x;
+            out.py = y;
+        }
+
+        inline void CurveTo( Outline& out, const Matrix& m, float cx, float cy, float x, float y )
+        {
+            // Enough segments to stay within a fifth of a pixel of the curve: the chord of a
+            // quadratic is at most |p0 - 2c + p1| / (4 n^2) off it
+            const float ax = out.px - 2.0f * cx + x, ay = out.py - 2.0f * cy + y;
+            const float dx = ( m.a * ax + m.c * ay ) * out.sx, dy = ( m.b * ax + m.d * ay ) * out.sy;
+            const float fDeviation = std::sqrt( dx * dx + dy * dy );
+            const int n = std::isfinite( fDeviation ) ? std::min( 1 + int( std::sqrt( std::min( fDeviation, 4096.0f ) * 1.25f ) ), 64 ) : 1;
+            const float x0 = out.px, y0 = out.py;
+            for( int i = 1; i <= n; i++ )
+            {
+                const float t = float( i ) / float( n ), u = 1.0f - t;
+                LineTo( out, m, u * u * x0 + 2.0f * u * t * cx + t * t * x, u * u * y0 + 2.0f * u * t * cy + t * t * y );
+            }
+        }
+
+        inline void AddSimpleGlyph( Outline& out, const Bytes& bytes, size_t nStart, size_t nEnd, int nContours, const Matrix& m )
+        {
+            // Flags, then x deltas, then y deltas of every point
+            const size_t nEndPoints = nStart + 10;
+            const int nPoints = bytes.U16( nEndPoints + size_t( nContours - 1 ) * 2 ) + 1;
+            size_t p = nEndPoints + size_t( nContours ) * 2;
+            p += 2 + bytes.U16( p );        // skip the instructions
+            if( p > nEnd )
+                return;
+
+            std::vector<Point> vPoints( static_cast<size_t>( nPoints ) );
+            for( int i = 0; i < nPoints; )
+            {
+                const uint8_t nFlags = bytes.U8( p++ );
+                int nRepeat = 1;
+                if( nFlags & 8 )
+                    nRepeat += bytes.U8( p++ );
+                for( ; nRepeat > 0 && i < nPoints; nRepeat--, i++ )
+                    vPoints[size_t( i )].flags = nFlags;
+            }
+
+            int x = 0, y = 0;
+            for( auto& pt : vPoints )
+            {
+                if( pt.flags & 2 )              { x += ( pt.flags & 16 ) ? bytes.U8( p ) : -bytes.U8( p ); p++; }
+                else if( !( pt.flags & 16 ) )   { x += bytes.S16( p ); p += 2; }
+                pt.x = float( x );
+            }
+            for( auto& pt : vPoints )
+            {
+                if( pt.flags & 4 )              { y += ( pt.flags & 32 ) ? bytes.U8( p ) : -bytes.U8( p ); p++; }
+                else if( !( pt.flags & 32 ) )   { y += bytes.S16( p ); p += 2; }
+                pt.y = float( y );
+            }
+
+            // Each contour is a closed loop of on curve points and quadratic control points, with an
+            // on curve point implied halfway between consecutive control points
+            int nFirstPoint = 0;
+            for( int i = 0; i < nContours; i++ )
+            {
+                const int nLast = bytes.U16( nEndPoints + size_t( i ) * 2 );
+                const int nCount = nLast - nFirstPoint + 1;
+                if( nCount < 2 || nLast >= nPoints )
+                {
+                    nFirstPoint = std::max( nFirstPoint, nLast + 1 );
+                    continue;
+                }
+
+                const Point* pts = vPoints.data() + nFirstPoint;
+                const bool bFirstOn = pts[0].flags & 1, bLastOn = pts[nCount - 1].flags & 1;
+                float sx, sy;
+                int nSkip = 1, nSteps = nCount - 1;
+                if( bFirstOn )      { sx = pts[0].x; sy = pts[0].y; }
+                else if( bLastOn )  { sx = pts[nCount - 1].x; sy = pts[nCount - 1].y; nSkip = 0; }
+                else                { sx = ( pts[0].x + pts[nCount - 1].x ) * 0.5f; sy = ( pts[0].y + pts[nCount - 1].y ) * 0.5f; nSkip = 0; nSteps = nCount; }
+
+                out.px = sx;
+                out.py = sy;
+                bool bControl = false;
+                float cx = 0.0f, cy = 0.0f;
+                for( int j = 0; j < nSteps; j++ )
+                {
+                    const Point& q = pts[nSkip + j];
+                    if( q.flags & 1 )
+                    {
+                        if( bControl ) CurveTo( out, m, cx, cy, q.x, q.y );
+                        else           LineTo( out, m, q.x, q.y );
+                        bControl = false;
+                    }
+                    else
+                    {
+                        if( bControl )
+                            CurveTo( out, m, cx, cy, ( cx + q.x ) * 0.5f, ( cy + q.y ) * 0.5f );
+                        cx = q.x;
+                        cy = q.y;
+                        bControl = true;
+                    }
+                }
+                if( bControl ) CurveTo( out, m, cx, cy, sx, sy );
+                else           LineTo( out, m, sx, sy );
+                nFirstPoint = nLast + 1;
+            }
+        }
+
+        inline void AddGlyph( Outline& out, const FontInfo& info, int nGlyph, const Matrix& m, int nDepth )
+        {
+            size_t nStart, nEnd;
+            if( nDepth > 8 || !GlyphRange( info, nGlyph, nStart, nEnd ) )
+                return;
+
+            const Bytes& bytes = info.bytes;
+            const int nContours = bytes.S16( nStart );
+            if( nContours > 0 )
+            {
+                AddSimpleGlyph( out, bytes, nStart, nEnd, nContours, m );
+                return;
+            }
+            if( nContours == 0 )
+                return;
+
+            // A composite glyph: other glyphs, each moved and optionally scaled
+            for( size_t p = nStart + 10; p + 4 <= nEnd && !out.bFull; )
+            {
+                // However the composites nest, only so many components are followed per glyph
+                if( ++out.nComponents > 4096 )
+                    return;
+
+                const uint16_t nFlags = bytes.U16( p ), nComponent = bytes.U16( p + 2 );
+                float dx, dy;
+                p += 4;
+                if( nFlags & 1 )    { dx = bytes.S16( p ); dy = bytes.S16( p + 2 ); p += 4; }     // 16 bit arguments
+                else                { dx = float( int8_t( bytes.U8( p ) ) ); dy = float( int8_t( bytes.U8( p + 1 ) ) ); p += 2; }
+                if( !( nFlags & 2 ) )
+                    dx = dy = 0.0f;     // aligned by matching points, which isn't supported
+
+                Matrix c;
+                if( nFlags & 8 )        { c.a = c.d = bytes.S16( p ) / 16384.0f; p += 2; }
+                else if( nFlags & 64 )  { c.a = bytes.S16( p ) / 16384.0f; c.d = bytes.S16( p + 2 ) / 16384.0f; p += 4; }
+                else if( nFlags & 128 ) { c.a = bytes.S16( p ) / 16384.0f; c.b = bytes.S16( p + 2 ) / 16384.0f;
+                                          c.c = bytes.S16( p + 4 ) / 16384.0f; c.d = bytes.S16( p + 6 ) / 16384.0f; p += 8; }
+
+                // Offsets are in the parent's units, unless the component asks for them to be scaled too
+                if( nFlags & 0x800 )    { c.e = c.a * dx + c.c * dy; c.f = c.b * dx + c.d * dy; }
+                else                    { c.e = dx; c.f = dy; }
+
+                Matrix combined;
+                combined.a = m.a * c.a + m.c * c.b;
+                combined.b = m.b * c.a + m.d * c.b;
+                combined.c = m.a * c.c + m.c * c.d;
+                combined.d = m.b * c.c + m.d * c.d;
+                combined.e = m.a * c.e + m.c * c.f + m.e;
+                combined.f = m.b * c.e + m.d * c.f + m.f;
+                AddGlyph( out, info, nComponent, combined, nDepth + 1 );
+
+                if( !( nFlags & 32 ) )  // more components
+                    break;
+            }
+        }
+
+        // Adds the signed area a line segment covers to the left of it to acc, one row of nStride
+        // floats per pixel row. Summed along a row, the areas give the coverage of each pixel
+        inline void Accumulate( float* acc, int w, int h, int nStride, const Edge& e )
+        {
+            const float fDir = e.y0 < e.y1 ? 1.0f : -1.0f;
+            const float x0 = e.y0 < e.y1 ? e.x0 : e.x1, y0 = std::min( e.y0, e.y1 );
+            const float x1 = e.y0 < e.y1 ? e.x1 : e.x0, y1 = std::max( e.y0, e.y1 );
+            if( y1 <= 0.0f || y0 >= float( h ) )
+                return;
+
+            const float dxdy = ( x1 - x0 ) / ( y1 - y0 );
+            const int nStartY = y0 < 0.0f ? 0 : int( y0 );
+            const int nEndY = y1 > float( h ) ? h : int( std::ceil( y1 ) );
+            float x = x0 + dxdy * ( float( nStartY ) > y0 ? float( nStartY ) - y0 : 0.0f );
+
+            for( int y = nStartY; y < nEndY; y++ )
+            {
+                float* row = acc + size_t( y ) * size_t( nStride );
+                const float fTop = std::max( float( y ), y0 ), fBottom = std::min( float( y + 1 ), y1 );
+                const float dy = fBottom - fTop, d = dy * fDir;
+                const float xNext = x + dxdy * dy;
+
+                // Ink outside the bitmap is pushed onto its edge, which keeps the winding of the pixels inside
+                const float xa = std::clamp( std::min( x, xNext ), 0.0f, float( w ) );
+                const float xb = std::clamp( std::max( x, xNext ), 0.0f, float( w ) );
+                const int ia = int( xa ), ib = int( std::ceil( xb ) );
+
+                if( ib <= ia + 1 )
+                {
+                    // Within one pixel: the part right of the segment's mean x goes to the next pixel
+                    const float fRight = ( xa + xb ) * 0.5f - float( ia );
+                    row[ia]     += d * ( 1.0f - fRight );
+                    row[ia + 1] += d * fRight;
+                }
+                else
+                {
+                    // Across several pixels: the covered area grows linearly between the two ends
+                    const float s = 1.0f / ( xb - xa );
+                    const float fa = xa - float( ia ), fb = xb - float( ib - 1 );
+                    const float fFirst = 0.5f * s * ( 1.0f - fa ) * ( 1.0f - fa );
+                    const float fLast = 0.5f * s * fb * fb;
+
+                    row[ia] += d * fFirst;
+                    if( ib == ia + 2 )
+                        row[ia + 1] += d * ( 1.0f - fFirst - fLast );
+                    else
+                    {
+                        float a = s * ( 1.5f - fa );
+                        row[ia + 1] += d * ( a - fFirst );
+                        for( int i = ia + 2; i < ib - 1; i++ )
+                            row[i] += d * s;
+                        a += float( ib - ia - 3 ) * s;
+                        row[ib - 1] += d * ( 1.0f - a - fLast );
+                    }
+                    row[ib] += d * fLast;
+                }
+                x = xNext;
+            }
+        }
+
+        // Float to int for pixel boxes, saturating rather than overflowing
+        inline int ClampToInt( float f )
+        {
+            return std::isfinite( f ) ? int( std::clamp( f, -1e6f, 1e6f ) ) : 0;
+        }
+    }
+
+
+    inline int GetFontOffsetForIndex( const uint8_t* pData, size_t nSize, int nIndex )
+    {
+        const Bytes bytes = { pData, nSize };
+        if( detail::IsFont( bytes, 0 ) )
+            return nIndex == 0 ? 0 : -1;
+
+        if( bytes.Tag( 0, "ttcf" ) )
+        {
+            const uint32_t nVersion = bytes.U32( 4 );
+            if( nVersion == 0x00010000 || nVersion == 0x00020000 )
+            {
+                const uint32_t nCount = bytes.U32( 8 );
+                if( nIndex < 0 || uint32_t( nIndex ) >= nCount )
+                    return -1;
+                const uint32_t nOffset = bytes.U32( 12 + size_t( nIndex ) * 4 );
+                return nOffset < nSize && nOffset <= uint32_t( INT32_MAX ) ? int( nOffset ) : -1;
+            }
+        }
+        return -1;
+    }
+
+
+    inline bool InitFont( FontInfo& info, const uint8_t* pData, size_t nSize, int nOffset )
+    {
+        info = FontInfo();
+        const Bytes bytes = { pData, nSize };
+        if( pData == nullptr || nOffset < 0 || !detail::IsFont( bytes, size_t( nOffset ) ) )
+            return false;
+
+        const size_t nFont = size_t( nOffset );
+        size_t nCmapLength = 0, nLocaLength = 0, nGlyfLength = 0, nHeadLength = 0, nHheaLength = 0;
+        const size_t nCmap = detail::FindTable( bytes, nFont, "cmap", &nCmapLength );
+        const size_t nMaxp = detail::FindTable( bytes, nFont, "maxp" );
+        info.bytes = bytes;
+        info.nLoca = detail::FindTable( bytes, nFont, "loca", &nLocaLength );
+        info.nHead = detail::FindTable( bytes, nFont, "head", &nHeadLength );
+        info.nGlyf = detail::FindTable( bytes, nFont, "glyf", &nGlyfLength );
+        info.nHhea = detail::FindTable( bytes, nFont, "hhea", &nHheaLength );
+        info.nHmtx = detail::FindTable( bytes, nFont, "hmtx" );
+        info.nGlyfEnd = info.nGlyf + nGlyfLength;
+
+        // Only truetype outlines ('glyf') are rasterised here
+        if( !nCmap || !info.nLoca || !info.nHead || !info.nGlyf || !info.nHhea || !info.nHmtx || nHeadLength < 54 || nHheaLength < 36 )
+            return false;
+
+        // No more glyphs than the 'loca' table has room for
+        info.nLocaFormat = bytes.S16( info.nHead + 50 );
+        if( info.nLocaFormat != 0 && info.nLocaFormat != 1 )
+            return false;
+        const size_t nLocaGlyphs = nLocaLength / ( info.nLocaFormat == 0 ? 2 : 4 );
+        info.nGlyphs = int( nLocaGlyphs > 0 ? nLocaGlyphs - 1 : 0 );
+        if( nMaxp )
+            info.nGlyphs = std::min( info.nGlyphs, int( bytes.U16( nMaxp + 4 ) ) );
+
+        // The unicode mapping, full repertoire ones before the BMP only ones
+        const int nSubtables = bytes.U16( nCmap + 2 );
+        int nBest = 0;
+        for( int i = 0; i < nSubtables; i++ )
+        {
+            const size_t nRecord = nCmap + 4 + 8 * size_t( i );
+            const int nPlatform = bytes.U16( nRecord ), nEncoding = bytes.U16( nRecord + 2 );
+            int nRank = 0;
+            if( nPlatform == 3 && nEncoding == 10 )                             nRank = 4;  // microsoft, unicode full
+            else if( nPlatform == 0 && ( nEncoding == 4 || nEncoding == 6 ) )   nRank = 3;  // unicode, full
+            else if( nPlatform == 3 && nEncoding == 1 )                         nRank = 2;  // microsoft, unicode BMP
+            else if( nPlatform == 0 )                                           nRank = 1;  // unicode, BMP
+            const size_t nSubtable = bytes.U32( nRecord + 4 );
+            if( nRank > nBest && nSubtable < nCmapLength )
+            {
+                nBest = nRank;
+                info.nIndexMap = nCmap + nSubtable;
+            }
+        }
+        return info.nIndexMap != 0;
+    }
+
+
+    inline float ScaleForPixelHeight( const FontInfo& info, float fPixels )
+    {
+        const int nHeight = info.bytes.S16( info.nHhea + 4 ) - info.bytes.S16( info.nHhea + 6 );
+        return nHeight > 0 ? fPixels / float( nHeight ) : 0.0f;
+    }
+
+
+    inline float ScaleForMappingEmToPixels( const FontInfo& info, float fPixels )
+    {
+        const int nUnitsPerEm = info.bytes.U16( info.nHead + 18 );
+        return nUnitsPerEm > 0 ? fPixels / float( nUnitsPerEm ) : 0.0f;
+    }
+
+
+    inline void GetFontVMetrics( const FontInfo& info, int& nAscent, int& nDescent, int& nLineGap )
+    {
+        nAscent  = info.bytes.S16( info.nHhea + 4 );
+        nDescent = info.bytes.S16( info.nHhea + 6 );
+        nLineGap = info.bytes.S16( info.nHhea + 8 );
+    }
+
+
+    inline void GetFontBoundingBox( const FontInfo& info, int& x0, int& y0, int& x1, int& y1 )
+    {
+        x0 = info.bytes.S16( info.nHead + 36 );
+        y0 = info.bytes.S16( info.nHead + 38 );
+        x1 = info.bytes.S16( info.nHead + 40 );
+        y1 = info.bytes.S16( info.nHead + 42 );
+    }
+
+
+    inline void GetGlyphHMetrics( const FontInfo& info, int nGlyph, int& nAdvance, int& nBearing )
+    {
+        // Glyphs past the last long metric share its advance and only have a bearing of their own
+        const int nLongMetrics = info.bytes.U16( info.nHhea + 34 );
+        const size_t nHmtx = info.nHmtx;
+        nAdvance = nBearing = 0;
+        if( nGlyph < 0 || nLongMetrics == 0 )
+            return;
+        if( nGlyph < nLongMetrics )
+        {
+            nAdvance = info.bytes.U16( nHmtx + 4 * size_t( nGlyph ) );
+            nBearing = info.bytes.S16( nHmtx + 4 * size_t( nGlyph ) + 2 );
+        }
+        else
+        {
+            nAdvance = info.bytes.U16( nHmtx + 4 * size_t( nLongMetrics - 1 ) );
+            nBearing = info.bytes.S16( nHmtx + 4 * size_t( nLongMetrics ) + 2 * size_t( nGlyph - nLongMetrics ) );
+        }
+    }
+
+
+    inline int FindGlyphIndex( const FontInfo& info, uint32_t nCodepoint )
+    {
+        const Bytes& bytes = info.bytes;
+        const size_t nMap = info.nIndexMap;
+        const uint32_t c = nCodepoint;
+        uint32_t nGlyph = 0;
+
+        switch( bytes.U16( nMap ) )
+        {
+        case 0:
+        {
+            // Byte array of the first 256 codepoints
+            const uint32_t nLength = bytes.U16( nMap + 2 );
+            nGlyph = c < 256 && 6 + c < nLength ? bytes.U8( nMap + 6 + c ) : 0;
+            break;
+        }
+
+        case 6:
+        {
+            // Dense array of a range of codepoints
+            const uint32_t nFirst = bytes.U16( nMap + 6 ), nCount = bytes.U16( nMap + 8 );
+            nGlyph = c >= nFirst && c - nFirst < nCount ? bytes.U16( nMap + 10 + size_t( c - nFirst ) * 2 ) : 0;
+            break;
+        }
+
+        case 4:
+        {
+            // Segments of consecutive codepoints in the BMP, binary searched by their last codepoint
+            if( c > 0xFFFF )
+                break;
+            const size_t nSegments = bytes.U16( nMap + 6 ) / 2;
+            const size_t nEndCodes = nMap + 14, nStartCodes = nEndCodes + nSegments * 2 + 2;
+            const size_t nDeltas = nStartCodes + nSegments * 2, nRanges = nDeltas + nSegments * 2;
+
+            size_t lo = 0, hi = nSegments;
+            while( lo < hi )
+            {
+                const size_t mid = ( lo + hi ) / 2;
+                if( bytes.U16( nEndCodes + mid * 2 ) < c ) lo = mid + 1;
+                else                                       hi = mid;
+            }
+            if( lo >= nSegments )
+                break;
+
+            const uint32_t nStart = bytes.U16( nStartCodes + lo * 2 );
+            if( c < nStart )
+                break;
+
+            const uint32_t nDelta = uint32_t( bytes.S16( nDeltas + lo * 2 ) );
+            const uint32_t nRange = bytes.U16( nRanges + lo * 2 );
+            if( nRange == 0 )
+                nGlyph = ( c + nDelta ) & 0xFFFF;
+            else
+            {
+                const uint32_t nIndexed = bytes.U16( nRanges + lo * 2 + nRange + size_t( c - nStart ) * 2 );
+                nGlyph = nIndexed == 0 ? 0 : ( nIndexed + nDelta ) & 0xFFFF;
+            }
+            break;
+        }
+
+        case 12:
+        case 13:
+        {
+            // Groups of consecutive codepoints, mapped to consecutive glyphs (12) or one glyph (13)
+            const bool bConsecutive = bytes.U16( nMap ) == 12;
+            size_t lo = 0, hi = bytes.U32( nMap + 12 );
+            hi = std::min( hi, ( bytes.nSize - std::min( bytes.nSize, nMap + 16 ) ) / 12 );
+            while( lo < hi )
+            {
+                const size_t mid = ( lo + hi ) / 2;
+                const size_t nGroup = nMap + 16 + mid * 12;
+                const uint32_t nStart = bytes.U32( nGroup ), nEnd = bytes.U32( nGroup + 4 );
+                if( c < nStart )    hi = mid;
+                else if( c > nEnd ) lo = mid + 1;
+                else
+                {
+                    nGlyph = bytes.U32( nGroup + 8 ) + ( bConsecutive ? c - nStart : 0 );
+                    break;
+                }
+            }
+            break;
+        }
+        }
+
+        return nGlyph < uint32_t( info.nGlyphs ) ? int( nGlyph ) : 0;
+    }
+
+
+    inline void GetGlyphBitmapBox( const FontInfo& info, int nGlyph, float fScaleX, float fScaleY, int& x0, int& y0, int& x1, int& y1 )
+    {
+        size_t nStart, nEnd;
+        x0 = y0 = x1 = y1 = 0;
+        if( !detail::GlyphRange( info, nGlyph, nStart, nEnd ) )
+            return;
+
+        // The box stored with the outline, y flipped to point down
+        x0 = detail::ClampToInt( std::floor(  info.bytes.S16( nStart + 2 ) * fScaleX ) );
+        y0 = detail::ClampToInt( std::floor( -info.bytes.S16( nStart + 8 ) * fScaleY ) );
+        x1 = detail::ClampToInt( std::ceil (  info.bytes.S16( nStart + 6 ) * fScaleX ) );
+        y1 = detail::ClampToInt( std::ceil ( -info.bytes.S16( nStart + 4 ) * fScaleY ) );
+    }
+
+
+    inline void MakeGlyphBitmap( const FontInfo& info, uint8_t* pOutput, int w, int h, int nStride, float fScaleX, float fScaleY, int nGlyph )
+    {
+        if( w <= 0 || h <= 0 )
+            return;
+        for( int y = 0; y < h; y++ )
+            std::fill_n( pOutput + size_t( y ) * size_t( nStride ), size_t( w ), uint8_t( 0 ) );
+
+        int x0, y0, x1, y1;
+        GetGlyphBitmapBox( info, nGlyph, fScaleX, fScaleY, x0, y0, x1, y1 );
+
+        detail::Outline out;
+        out.sx = fScaleX;
+        out.sy = -fScaleY;
+        out.ox = float( -x0 );
+        out.oy = float( -y0 );
+        detail::AddGlyph( out, info, nGlyph, detail::Matrix(), 0 );
+
+        // One spare column on the right takes the area pushed past the last pixel
+        const int nAccStride = w + 2;
+        std::vector<float> vAcc( size_t( nAccStride ) * size_t( h ), 0.0f );
+        for( const auto& edge : out.vEdges )
+            detail::Accumulate( vAcc.data(), w, h, nAccStride, edge );
+
+        for( int y = 0; y < h; y++ )
+        {
+            const float* row = vAcc.data() + size_t( y ) * size_t( nAccStride );
+            uint8_t* pixels = pOutput + size_t( y ) * size_t( nStride );
+            float fSum = 0.0f;
+            for( int x = 0; x < w; x++ )
+            {
+                fSum += row[x];
+                const float fCoverage = std::abs( fSum );
+                pixels[x] = uint8_t( fCoverage >= 1.0f ? 255 : int( fCoverage * 255.0f + 0.5f ) );
+            }
+        }
+    }
+}
+
+#endif